@@ -39,7 +39,10 @@ enum operation_t
 {
   nominal_glyphs,
   glyph_h_advances,
+  glyph_v_advances,
+  glyph_v_origins,
   glyph_extents,
+  glyph_extents_batch,
   glyph_shape,
 };
 
@@ -150,6 +153,32 @@ static void BM_Font (benchmark::State &state,
       free (glyphs);
       break;
     }
+    case glyph_v_advances:
+    {
+      hb_codepoint_t *glyphs = (hb_codepoint_t *) calloc (num_glyphs, sizeof (hb_codepoint_t));
+      hb_position_t *advances = (hb_position_t *) calloc (num_glyphs, sizeof (hb_codepoint_t));
+
+      for (unsigned g = 0; g < num_glyphs; g++)
+        glyphs[g] = g;
+
+      for (auto _ : state)
+	hb_font_get_glyph_v_advances (font,
+				      num_glyphs,
+				      glyphs, sizeof (*glyphs),
+				      advances, sizeof (*advances));
+
+      free (advances);
+      free (glyphs);
+      break;
+    }
+    case glyph_v_origins:
+    {
+      hb_position_t x, y;
+      for (auto _ : state)
+	for (unsigned gid = 0; gid < num_glyphs; ++gid)
+	  hb_font_get_glyph_v_origin (font, gid, &x, &y);
+      break;
+    }
     case glyph_extents:
     {
       hb_glyph_extents_t extents;
@@ -158,6 +187,24 @@ static void BM_Font (benchmark::State &state,
 	  hb_font_get_glyph_extents (font, gid, &extents);
       break;
     }
+    case glyph_extents_batch:
+    {
+      hb_codepoint_t *glyphs = (hb_codepoint_t *) calloc (num_glyphs, sizeof (hb_codepoint_t));
+      hb_glyph_extents_t *extents = (hb_glyph_extents_t *) calloc (num_glyphs, sizeof (hb_glyph_extents_t));
+
+      for (unsigned g = 0; g < num_glyphs; g++)
+        glyphs[g] = g;
+
+      for (auto _ : state)
+	hb_font_get_glyph_extents_batch (font,
+					 num_glyphs,
+					 glyphs, sizeof (*glyphs),
+					 extents, sizeof (*extents));
+
+      free (extents);
+      free (glyphs);
+      break;
+    }
     case glyph_shape:
     {
       hb_draw_funcs_t *draw_funcs = _draw_funcs_create ();
@@ -232,7 +279,10 @@ int main(int argc, char** argv)
 
   TEST_OPERATION (nominal_glyphs, benchmark::kMicrosecond);
   TEST_OPERATION (glyph_h_advances, benchmark::kMicrosecond);
+  TEST_OPERATION (glyph_v_advances, benchmark::kMicrosecond);
+  TEST_OPERATION (glyph_v_origins, benchmark::kMicrosecond);
   TEST_OPERATION (glyph_extents, benchmark::kMicrosecond);
+  TEST_OPERATION (glyph_extents_batch, benchmark::kMicrosecond);
   TEST_OPERATION (glyph_shape, benchmark::kMicrosecond);
 
 #undef TEST_OPERATION
@@ -1,5 +1,6 @@
 #include "benchmark/benchmark.h"
 #include <cstring>
+#include <vector>
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -52,6 +53,7 @@ enum backend_t { HARFBUZZ, FREETYPE };
 static void BM_Shape (benchmark::State &state,
 		      bool is_var,
 		      backend_t backend,
+		      bool batch,
 		      const test_input_t &input)
 {
   hb_font_t *font;
@@ -88,34 +90,102 @@ static void BM_Shape (benchmark::State &state,
   unsigned orig_text_length;
   const char *orig_text = hb_blob_get_data (text_blob, &orig_text_length);
 
-  hb_buffer_t *buf = hb_buffer_create ();
-  for (auto _ : state)
+  if (batch)
   {
-    unsigned text_length = orig_text_length;
-    const char *text = orig_text;
+    std::vector<hb_buffer_t *> bufs;
+    for (auto _ : state)
+    {
+      unsigned text_length = orig_text_length;
+      const char *text = orig_text;
+
+      unsigned num_bufs = 0;
+      const char *end;
+      while ((end = (const char *) memchr (text, '\n', text_length)))
+      {
+	if (num_bufs == bufs.size ())
+	  bufs.push_back (hb_buffer_create ());
+	hb_buffer_t *buf = bufs[num_bufs++];
+	hb_buffer_clear_contents (buf);
+	hb_buffer_add_utf8 (buf, text, text_length, 0, end - text);
+	hb_buffer_guess_segment_properties (buf);
 
-    const char *end;
-    while ((end = (const char *) memchr (text, '\n', text_length)))
+	unsigned skip = end - text + 1;
+	text_length -= skip;
+	text += skip;
+      }
+      hb_shape_batch (font, bufs.data (), num_bufs, nullptr, 0, nullptr);
+    }
+    for (hb_buffer_t *buf : bufs)
+      hb_buffer_destroy (buf);
+  }
+  else
+  {
+    hb_buffer_t *buf = hb_buffer_create ();
+    for (auto _ : state)
     {
-      hb_buffer_clear_contents (buf);
-      hb_buffer_add_utf8 (buf, text, text_length, 0, end - text);
-      hb_buffer_guess_segment_properties (buf);
-      hb_shape (font, buf, nullptr, 0);
-
-      unsigned skip = end - text + 1;
-      text_length -= skip;
-      text += skip;
+      unsigned text_length = orig_text_length;
+      const char *text = orig_text;
+
+      const char *end;
+      while ((end = (const char *) memchr (text, '\n', text_length)))
+      {
+	hb_buffer_clear_contents (buf);
+	hb_buffer_add_utf8 (buf, text, text_length, 0, end - text);
+	hb_buffer_guess_segment_properties (buf);
+	hb_shape (font, buf, nullptr, 0);
+
+	unsigned skip = end - text + 1;
+	text_length -= skip;
+	text += skip;
+      }
     }
+    hb_buffer_destroy (buf);
   }
-  hb_buffer_destroy (buf);
 
   hb_blob_destroy (text_blob);
   hb_font_destroy (font);
 }
 
+/* Time to first shape: creating a face and font and shaping the first
+ * line of text, which is dominated by loading the layout tables. */
+static void BM_ShapeCold (benchmark::State &state,
+			  const test_input_t &input)
+{
+  hb_blob_t *blob = hb_blob_create_from_file_or_fail (input.font_path);
+  assert (blob);
+
+  hb_blob_t *text_blob = hb_blob_create_from_file_or_fail (input.text_path);
+  assert (text_blob);
+  unsigned text_length;
+  const char *text = hb_blob_get_data (text_blob, &text_length);
+  const char *end = (const char *) memchr (text, '\n', text_length);
+  if (end)
+    text_length = end - text;
+
+  hb_buffer_t *buf = hb_buffer_create ();
+  for (auto _ : state)
+  {
+    hb_face_t *face = hb_face_create (blob, 0);
+    hb_font_t *font = hb_font_create (face);
+
+    hb_buffer_clear_contents (buf);
+    hb_buffer_add_utf8 (buf, text, text_length, 0, text_length);
+    hb_buffer_guess_segment_properties (buf);
+    hb_shape (font, buf, nullptr, 0);
+
+    hb_font_destroy (font);
+    hb_face_destroy (face);
+  }
+  hb_buffer_destroy (buf);
+
+  hb_blob_destroy (text_blob);
+  hb_blob_destroy (blob);
+}
+
 static void test_backend (backend_t backend,
 			  const char *backend_name,
 			  bool variable,
+			  bool batch,
 			  const test_input_t &test_input)
 {
   char name[1024] = "BM_Shape";
@@ -129,8 +199,9 @@ static void test_backend (backend_t backend,
   strcat (name, variable ? "/var" : "");
   strcat (name, "/");
   strcat (name, backend_name);
+  strcat (name, batch ? "/batch" : "");
 
-  benchmark::RegisterBenchmark (name, BM_Shape, variable, backend, test_input)
+  benchmark::RegisterBenchmark (name, BM_Shape, variable, backend, batch, test_input)
    ->Unit(benchmark::kMillisecond);
 }
 
@@ -153,13 +224,26 @@ int main(int argc, char** argv)
   for (unsigned i = 0; i < num_tests; i++)
   {
     auto& test_input = tests[i];
+
+    char name[1024] = "BM_ShapeCold";
+    const char *p;
+    strcat (name, "/");
+    p = strrchr (test_input.font_path, '/');
+    strcat (name, p ? p + 1 : test_input.font_path);
+    strcat (name, "/");
+    p = strrchr (test_input.text_path, '/');
+    strcat (name, p ? p + 1 : test_input.text_path);
+    benchmark::RegisterBenchmark (name, BM_ShapeCold, test_input)
+     ->Unit(benchmark::kMicrosecond);
+
     for (int variable = 0; variable < int (test_input.is_variable) + 1; variable++)
     {
       bool is_var = (bool) variable;
 
-      test_backend (HARFBUZZ, "hb", is_var, test_input);
+      test_backend (HARFBUZZ, "hb", is_var, false, test_input);
+      test_backend (HARFBUZZ, "hb", is_var, true, test_input);
 #ifdef HAVE_FREETYPE
-      test_backend (FREETYPE, "ft", is_var, test_input);
+      test_backend (FREETYPE, "ft", is_var, false, test_input);
 #endif
     }
   }
@@ -89,11 +89,97 @@ struct PairPosFormat1_3
 
   const Coverage &get_coverage () const { return this+coverage; }
 
-  bool apply (hb_ot_apply_context_t *c) const
+  /* The coverage indices of the first glyphs below end_first, and the
+   * pairs starting with those, in native-endian hash maps; built for
+   * the lowest first glyphs, as far as HB_PAIR_POS_ACCEL_MAX_PAIRS
+   * pairs go, and only if the memory they take is left of *budget.
+   * Other first glyphs take the binary searches. */
+  struct external_cache_t
+  {
+    hb_codepoint_t end_first;
+    hb_map_t first;	/* First glyph to coverage index. */
+    hb_map_t pairs;	/* First << 16 | second glyph to record index. */
+  };
+  external_cache_t *external_cache_create (hb_atomic_int_t *budget) const
+  {
+    const Coverage &cov = this+coverage;
+
+    /* The maps must agree with the binary searches; give up on coverage
+     * tables those would not work right on. */
+    unsigned count = 0;
+    hb_codepoint_t last = 0;
+    for (hb_codepoint_t g : cov.iter ())
+    {
+      if (unlikely (count && g <= last)) return nullptr;
+      last = g;
+      count++;
+    }
+    if (unlikely (!count || count != cov.get_population ())) return nullptr;
+
+    external_cache_t *cache = (external_cache_t *) hb_calloc (1, sizeof (external_cache_t));
+    if (unlikely (!cache)) return nullptr;
+    new (cache) external_cache_t ();
+
+    unsigned record_size = PairSet::get_record_size (valueFormat);
+    unsigned num_pairs = 0;
+    for (hb_codepoint_t first : cov.iter ())
+    {
+      unsigned index = cov.get_coverage (first);
+      const PairSet &set = this+pairSet[index];
+      if (first > 0xFFFFu || num_pairs + set.len > HB_PAIR_POS_ACCEL_MAX_PAIRS)
+	break;
+
+      bool ok = true;
+      for (unsigned i = 0; i < set.len; i++)
+      {
+	hb_codepoint_t second = set.get_second_glyph (i, record_size);
+	const PairValueRecord *record = set.find_record (second, record_size);
+	if (unlikely (second > 0xFFFFu || !record))
+	{
+	  ok = false;
+	  break;
+	}
+	cache->pairs.set (first << 16 | second,
+			  ((const char *) record - (const char *) set.get_record (0, record_size)) / record_size);
+      }
+      if (unlikely (!ok))
+	break;
+
+      cache->first.set (first, index);
+      cache->end_first = first + 1;
+      num_pairs += set.len;
+    }
+
+    if (unlikely (!cache->end_first || cache->first.in_error () || cache->pairs.in_error () ||
+		  !hb_accel_budget_take (budget, get_size (cache))))
+    {
+      external_cache_destroy (cache, nullptr);
+      return nullptr;
+    }
+    return cache;
+  }
+  static int get_size (const external_cache_t *cache)
+  {
+    return sizeof (external_cache_t) +
+	   (cache->first.mask ? cache->first.mask + 1 : 0) * sizeof (hb_map_t::item_t) +
+	   (cache->pairs.mask ? cache->pairs.mask + 1 : 0) * sizeof (hb_map_t::item_t);
+  }
+  static void external_cache_destroy (external_cache_t *cache,
+				      hb_atomic_int_t *budget)
+  {
+    hb_accel_budget_give (budget, get_size (cache));
+    cache->~external_cache_t ();
+    hb_free (cache);
+  }
+
+  bool apply (hb_ot_apply_context_t *c,
+	      external_cache_t *cache = nullptr) const
   {
     TRACE_APPLY (this);
     hb_buffer_t *buffer = c->buffer;
-    unsigned int index = (this+coverage).get_coverage  (buffer->cur().codepoint);
+    hb_codepoint_t first = buffer->cur().codepoint;
+    bool accelerated = cache && first < cache->end_first;
+    unsigned int index = accelerated ? cache->first.get (first) : (this+coverage).get_coverage (first);
     if (likely (index == NOT_COVERED)) return_trace (false);
 
     hb_ot_apply_context_t::skipping_iterator_t &skippy_iter = c->iter_input;
@@ -105,7 +191,17 @@ struct PairPosFormat1_3
       return_trace (false);
     }
 
-    return_trace ((this+pairSet[index]).apply (c, valueFormat, skippy_iter.idx));
+    const PairSet &set = this+pairSet[index];
+    hb_codepoint_t second = buffer->info[skippy_iter.idx].codepoint;
+    if (accelerated && second <= 0xFFFFu)
+    {
+      unsigned int i = cache->pairs.get (first << 16 | second);
+      const PairValueRecord *record = i == HB_MAP_VALUE_INVALID ? nullptr :
+				      set.get_record (i, PairSet::get_record_size (valueFormat));
+      return_trace (set.apply_record (c, valueFormat, record, skippy_iter.idx));
+    }
+
+    return_trace (set.apply (c, valueFormat, skippy_iter.idx));
   }
 
   bool subset (hb_subset_context_t *c) const
@@ -123,7 +123,32 @@ struct PairPosFormat2_4
 
   const Coverage &get_coverage () const { return this+coverage; }
 
-  bool apply (hb_ot_apply_context_t *c) const
+  struct external_cache_t
+  {
+    hb_ot_class_cache_t first;
+    hb_ot_class_cache_t second;
+  };
+  external_cache_t *external_cache_create (hb_atomic_int_t *budget HB_UNUSED) const
+  {
+    /* Not worth it for ClassDefs that are arrays. */
+    if ((this+classDef1).cost () + (this+classDef2).cost () < 4)
+      return nullptr;
+    external_cache_t *cache = (external_cache_t *) hb_malloc (sizeof (external_cache_t));
+    if (likely (cache))
+    {
+      cache->first.init ();
+      cache->second.init ();
+    }
+    return cache;
+  }
+  static void external_cache_destroy (external_cache_t *cache,
+				      hb_atomic_int_t *budget HB_UNUSED)
+  {
+    hb_free (cache);
+  }
+
+  bool apply (hb_ot_apply_context_t *c,
+	      external_cache_t *cache = nullptr) const
   {
     TRACE_APPLY (this);
     hb_buffer_t *buffer = c->buffer;
@@ -143,8 +168,10 @@ struct PairPosFormat2_4
     unsigned int len2 = valueFormat2.get_len ();
     unsigned int record_len = len1 + len2;
 
-    unsigned int klass1 = (this+classDef1).get_class (buffer->cur().codepoint);
-    unsigned int klass2 = (this+classDef2).get_class (buffer->info[skippy_iter.idx].codepoint);
+    unsigned int klass1 = (this+classDef1).get_class (buffer->cur().codepoint,
+						       cache ? &cache->first : nullptr);
+    unsigned int klass2 = (this+classDef2).get_class (buffer->info[skippy_iter.idx].codepoint,
+						       cache ? &cache->second : nullptr);
     if (unlikely (klass1 >= class1Count || klass2 >= class2Count))
     {
       buffer->unsafe_to_concat (buffer->idx, skippy_iter.idx + 1);
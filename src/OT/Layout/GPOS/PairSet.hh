@@ -93,20 +93,49 @@ struct PairSet
     }
   }
 
+  static unsigned int get_record_size (const ValueFormat *valueFormats)
+  {
+    unsigned int len1 = valueFormats[0].get_len ();
+    unsigned int len2 = valueFormats[1].get_len ();
+    return HBUINT16::static_size * (1 + len1 + len2);
+  }
+
+  const PairValueRecord *get_record (unsigned int i,
+                                     unsigned int record_size) const
+  { return &StructAtOffset<const PairValueRecord> (&firstPairValueRecord, record_size * i); }
+  hb_codepoint_t get_second_glyph (unsigned int i,
+                                   unsigned int record_size) const
+  { return get_record (i, record_size)->secondGlyph; }
+
+  const PairValueRecord *find_record (hb_codepoint_t second,
+                                      unsigned int record_size) const
+  {
+    return hb_bsearch (second,
+                       &firstPairValueRecord,
+                       len,
+                       record_size);
+  }
+
   bool apply (hb_ot_apply_context_t *c,
               const ValueFormat *valueFormats,
               unsigned int pos) const
+  {
+    const PairValueRecord *record = find_record (c->buffer->info[pos].codepoint,
+                                                 get_record_size (valueFormats));
+    return apply_record (c, valueFormats, record, pos);
+  }
+
+  /* Applies record, as found for the glyph at pos; nullptr if none was. */
+  bool apply_record (hb_ot_apply_context_t *c,
+                     const ValueFormat *valueFormats,
+                     const PairValueRecord *record,
+                     unsigned int pos) const
   {
     TRACE_APPLY (this);
     hb_buffer_t *buffer = c->buffer;
     unsigned int len1 = valueFormats[0].get_len ();
     unsigned int len2 = valueFormats[1].get_len ();
-    unsigned int record_size = HBUINT16::static_size * (1 + len1 + len2);
 
-    const PairValueRecord *record = hb_bsearch (buffer->info[pos].codepoint,
-                                                &firstPairValueRecord,
-                                                len,
-                                                record_size);
     if (record)
     {
       if (HB_BUFFER_MESSAGE_MORE && c->buffer->messaging ())
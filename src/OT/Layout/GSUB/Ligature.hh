@@ -29,6 +29,10 @@ struct Ligature
   bool intersects (const hb_set_t *glyphs) const
   { return hb_all (component, glyphs); }
 
+  unsigned get_component_count () const { return component.lenP1; }
+  hb_array_t<const typename Types::HBGlyphID> get_components () const
+  { return component.as_array (); }
+
   void closure (hb_closure_context_t *c) const
   {
     if (!intersects (c->glyphs)) return;
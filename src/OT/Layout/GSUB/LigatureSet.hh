@@ -24,6 +24,9 @@ struct LigatureSet
     return_trace (ligature.sanitize (c, this));
   }
 
+  unsigned get_ligature_count () const { return ligature.len; }
+  const Ligature<Types> &get_ligature (unsigned i) const { return this+ligature[i]; }
+
   bool intersects (const hb_set_t *glyphs) const
   {
     return
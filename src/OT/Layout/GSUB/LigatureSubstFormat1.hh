@@ -78,7 +78,253 @@ struct LigatureSubstFormat1_2
     return lig_set.would_apply (c);
   }
 
-  bool apply (hb_ot_apply_context_t *c) const
+  /* A trie over the components of the ligatures of each LigatureSet
+   * that has at least HB_LIGATURE_ACCEL_MIN_LIGATURES of them, if the
+   * memory it takes is left of *budget; see apply_trie(). */
+  struct external_cache_t
+  {
+    struct node_t
+    {
+      unsigned children;	/* First child, in nodes. */
+      unsigned num_children;
+      unsigned ligatures;	/* First ligature, in ligatures. */
+      unsigned num_ligatures;
+    };
+
+    hb_vector_t<unsigned> roots;	/* Root node per coverage index, or -1. */
+    hb_vector_t<node_t> nodes;
+    hb_vector_t<hb_codepoint_t> glyphs;	/* Component leading to each node. */
+    hb_vector_t<unsigned> ligatures;	/* Ligature indices in the LigatureSet,
+					 * ascending for each node. */
+  };
+
+  static int cmp_ligatures (const void *pa, const void *pb, void *arg)
+  {
+    const LigatureSet<Types> &set = *(const LigatureSet<Types> *) arg;
+    unsigned a = *(const unsigned *) pa;
+    unsigned b = *(const unsigned *) pb;
+    auto ca = set.get_ligature (a).get_components ();
+    auto cb = set.get_ligature (b).get_components ();
+    unsigned count = hb_min (ca.length, cb.length);
+    for (unsigned i = 0; i < count; i++)
+      if (ca[i] != cb[i])
+	return ca[i] < cb[i] ? -1 : 1;
+    if (ca.length != cb.length)
+      return ca.length < cb.length ? -1 : 1;
+    return a < b ? -1 : a > b ? 1 : 0;
+  }
+
+  /* Ligatures in order share their first depth components. */
+  static void build_trie_node (external_cache_t *cache,
+			       const LigatureSet<Types> &set,
+			       hb_array_t<const unsigned> order,
+			       unsigned depth,
+			       unsigned node_index)
+  {
+    unsigned count = order.length;
+
+    /* Ligatures ending here sort first, and in set order. */
+    unsigned i = 0;
+    unsigned first_ligature = cache->ligatures.length;
+    for (; i < count && set.get_ligature (order[i]).get_components ().length == depth; i++)
+      cache->ligatures.push (order[i]);
+    unsigned num_ligatures = cache->ligatures.length - first_ligature;
+
+    /* One child for each next component, all next to each other. */
+    unsigned first_child = cache->nodes.length;
+    unsigned num_children = 0;
+    for (unsigned j = i; j < count;)
+    {
+      hb_codepoint_t g = set.get_ligature (order[j]).get_components ()[depth];
+      while (j < count && set.get_ligature (order[j]).get_components ()[depth] == g)
+	j++;
+      typename external_cache_t::node_t node = {0, 0, 0, 0};
+      cache->nodes.push (node);
+      cache->glyphs.push (g);
+      num_children++;
+    }
+    if (unlikely (cache->nodes.in_error () || cache->glyphs.in_error ()))
+      return;
+
+    auto &node = cache->nodes.arrayZ[node_index];
+    node.children = first_child;
+    node.num_children = num_children;
+    node.ligatures = first_ligature;
+    node.num_ligatures = num_ligatures;
+
+    unsigned child = first_child;
+    for (unsigned j = i; j < count; child++)
+    {
+      unsigned start = j;
+      hb_codepoint_t g = cache->glyphs.arrayZ[child];
+      while (j < count && set.get_ligature (order[j]).get_components ()[depth] == g)
+	j++;
+      build_trie_node (cache, set, order.sub_array (start, j - start), depth + 1, child);
+    }
+  }
+
+  external_cache_t *external_cache_create (hb_atomic_int_t *budget) const
+  {
+    unsigned count = ligatureSet.len;
+    unsigned i;
+    for (i = 0; i < count; i++)
+      if ((this+ligatureSet[i]).get_ligature_count () >= HB_LIGATURE_ACCEL_MIN_LIGATURES)
+	break;
+    if (i == count)
+      return nullptr;
+
+    external_cache_t *cache = (external_cache_t *) hb_calloc (1, sizeof (external_cache_t));
+    if (unlikely (!cache))
+      return nullptr;
+    new (cache) external_cache_t ();
+
+    hb_vector_t<unsigned> order;
+    bool ok = cache->roots.resize (count);
+    for (i = 0; ok && i < count; i++)
+    {
+      cache->roots.arrayZ[i] = (unsigned) -1;
+      const LigatureSet<Types> &set = this+ligatureSet[i];
+      unsigned num_ligatures = set.get_ligature_count ();
+      if (num_ligatures < HB_LIGATURE_ACCEL_MIN_LIGATURES)
+	continue;
+
+      /* Ligatures with no components, or too many, never apply. */
+      order.reset ();
+      for (unsigned j = 0; j < num_ligatures; j++)
+      {
+	unsigned components = set.get_ligature (j).get_component_count ();
+	if (components && components <= HB_MAX_CONTEXT_LENGTH)
+	  order.push (j);
+      }
+      if (unlikely (order.in_error ()))
+      {
+	ok = false;
+	break;
+      }
+      hb_qsort (order.arrayZ, order.length, sizeof (unsigned), cmp_ligatures, (void *) &set);
+
+      unsigned root = cache->nodes.length;
+      typename external_cache_t::node_t node = {0, 0, 0, 0};
+      cache->nodes.push (node);
+      cache->glyphs.push (0);
+      build_trie_node (cache, set, order.as_array (), 0, root);
+      cache->roots.arrayZ[i] = root;
+
+      ok = !cache->nodes.in_error () && !cache->glyphs.in_error () && !cache->ligatures.in_error ();
+    }
+
+    if (unlikely (!ok || !hb_accel_budget_take (budget, get_size (cache))))
+    {
+      external_cache_destroy (cache, nullptr);
+      return nullptr;
+    }
+    return cache;
+  }
+  static int get_size (const external_cache_t *cache)
+  {
+    return sizeof (external_cache_t) +
+	   cache->roots.allocated * sizeof (cache->roots.arrayZ[0]) +
+	   cache->nodes.allocated * sizeof (cache->nodes.arrayZ[0]) +
+	   cache->glyphs.allocated * sizeof (cache->glyphs.arrayZ[0]) +
+	   cache->ligatures.allocated * sizeof (cache->ligatures.arrayZ[0]);
+  }
+  static void external_cache_destroy (external_cache_t *cache,
+				      hb_atomic_int_t *budget)
+  {
+    hb_accel_budget_give (budget, get_size (cache));
+    cache->~external_cache_t ();
+    hb_free (cache);
+  }
+
+  /* Instead of trying each ligature of the set in turn, follows the
+   * glyphs after the current one down the trie, and tries only the
+   * ligatures along that path, in set order.
+   *
+   * Which glyph a component is matched against depends on the component
+   * only for default-ignorables that may or may not be skipped; we fall
+   * back to the LigatureSet if we meet one.  Ligatures off the path
+   * would fail to match; that has no effect on the buffer when
+   * unsafe-to-concat flags are not produced, which the caller checks. */
+  bool apply_trie (hb_ot_apply_context_t *c,
+		   const LigatureSet<Types> &lig_set,
+		   const external_cache_t &cache,
+		   unsigned root) const
+  {
+    hb_buffer_t *buffer = c->buffer;
+    hb_ot_apply_context_t::skipping_iterator_t &skippy_iter = c->iter_input;
+    skippy_iter.reset (buffer->idx, 1);
+    skippy_iter.set_match_func (nullptr, nullptr);
+
+    unsigned path[HB_MAX_CONTEXT_LENGTH];
+    unsigned depth = 0;
+    path[depth++] = root;
+
+    unsigned pos = buffer->idx;
+    while (depth < HB_MAX_CONTEXT_LENGTH)
+    {
+      const auto &node = cache.nodes.arrayZ[path[depth - 1]];
+      if (!node.num_children)
+	break;
+
+      unsigned next = pos + 1;
+      auto skip = hb_ot_apply_context_t::matcher_t::SKIP_YES;
+      for (; next < buffer->len; next++)
+      {
+	skip = skippy_iter.may_skip (buffer->info[next]);
+	if (skip != hb_ot_apply_context_t::matcher_t::SKIP_YES)
+	  break;
+      }
+      if (next >= buffer->len)
+	break;
+      if (unlikely (skip == hb_ot_apply_context_t::matcher_t::SKIP_MAYBE))
+	return lig_set.apply (c);
+      if (skippy_iter.may_match (buffer->info[next], 0) == hb_ot_apply_context_t::matcher_t::MATCH_NO)
+	break;
+
+      hb_codepoint_t g = buffer->info[next].codepoint;
+      const hb_codepoint_t *glyphs = cache.glyphs.arrayZ + node.children;
+      unsigned lo = 0, hi = node.num_children;
+      while (lo < hi)
+      {
+	unsigned mid = (lo + hi) / 2;
+	if (glyphs[mid] < g)
+	  lo = mid + 1;
+	else
+	  hi = mid;
+      }
+      if (lo == node.num_children || glyphs[lo] != g)
+	break;
+
+      path[depth++] = node.children + lo;
+      pos = next;
+    }
+
+    unsigned cursor[HB_MAX_CONTEXT_LENGTH] = {};
+    for (;;)
+    {
+      unsigned best = (unsigned) -1;
+      unsigned best_depth = 0;
+      for (unsigned i = 0; i < depth; i++)
+      {
+	const auto &node = cache.nodes.arrayZ[path[i]];
+	if (cursor[i] < node.num_ligatures &&
+	    cache.ligatures.arrayZ[node.ligatures + cursor[i]] < best)
+	{
+	  best = cache.ligatures.arrayZ[node.ligatures + cursor[i]];
+	  best_depth = i;
+	}
+      }
+      if (best == (unsigned) -1)
+	return false;
+      cursor[best_depth]++;
+
+      if (lig_set.get_ligature (best).apply (c))
+	return true;
+    }
+  }
+
+  bool apply (hb_ot_apply_context_t *c,
+	      external_cache_t *cache = nullptr) const
   {
     TRACE_APPLY (this);
 
@@ -86,6 +332,10 @@ struct LigatureSubstFormat1_2
     if (likely (index == NOT_COVERED)) return_trace (false);
 
     const auto &lig_set = this+ligatureSet[index];
+    if (cache && index < cache->roots.length &&
+	cache->roots.arrayZ[index] != (unsigned) -1 &&
+	!(c->buffer->flags & HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT))
+      return_trace (apply_trie (c, lig_set, *cache, cache->roots.arrayZ[index]));
     return_trace (lig_set.apply (c));
   }
 
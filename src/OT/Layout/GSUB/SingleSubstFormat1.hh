@@ -87,6 +87,17 @@ struct SingleSubstFormat1_3
   bool would_apply (hb_would_apply_context_t *c) const
   { return c->len == 1 && (this+coverage).get_coverage (c->glyphs[0]) != NOT_COVERED; }
 
+  bool collect_single_substs (hb_collect_single_substs_context_t *c) const
+  {
+    const Coverage &cov = this+coverage;
+    hb_codepoint_t d = deltaGlyphID;
+    hb_codepoint_t mask = get_mask ();
+    for (hb_codepoint_t g : cov.iter ())
+      if (cov.get_coverage (g) != NOT_COVERED)
+	c->add (g, (g + d) & mask);
+    return true;
+  }
+
   bool apply (hb_ot_apply_context_t *c) const
   {
     TRACE_APPLY (this);
@@ -59,6 +59,18 @@ struct SingleSubstFormat2_4
   bool would_apply (hb_would_apply_context_t *c) const
   { return c->len == 1 && (this+coverage).get_coverage (c->glyphs[0]) != NOT_COVERED; }
 
+  bool collect_single_substs (hb_collect_single_substs_context_t *c) const
+  {
+    const Coverage &cov = this+coverage;
+    for (hb_codepoint_t g : cov.iter ())
+    {
+      unsigned int index = cov.get_coverage (g);
+      if (index != NOT_COVERED && index < substitute.len)
+	c->add (g, substitute[index]);
+    }
+    return true;
+  }
+
   bool apply (hb_ot_apply_context_t *c) const
   {
     TRACE_APPLY (this);
@@ -29,6 +29,21 @@ struct SubstLookup : Lookup
     return lookup_type_is_reverse (type);
   }
 
+  /* Whether all subtables are SingleSubst, possibly through Extension. */
+  bool is_single () const
+  {
+    unsigned int type = get_type ();
+    if (type == SubTable::Single)
+      return true;
+    if (type != SubTable::Extension)
+      return false;
+    unsigned int count = get_subtable_count ();
+    for (unsigned int i = 0; i < count; i++)
+      if (get_subtable (i).u.extension.get_type () != SubTable::Single)
+	return false;
+    return true;
+  }
+
   bool may_have_non_1to1 () const
   {
     hb_have_non_1to1_context_t c;
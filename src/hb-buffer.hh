@@ -32,6 +32,7 @@
 
 #include "hb.hh"
 #include "hb-unicode.hh"
+#include "hb-set-digest.hh"
 
 
 #ifndef HB_BUFFER_MAX_LEN_FACTOR
@@ -237,6 +238,22 @@ struct hb_buffer_t
 			unsigned int    cluster);
   HB_INTERNAL void add_info (const hb_glyph_info_t &glyph_info);
 
+  hb_set_digest_t digest () const
+  {
+    hb_set_digest_t d;
+    d.init ();
+    d.add_array (&info[0].codepoint, len, sizeof (info[0]));
+    return d;
+  }
+
+  hb_mask_t mask_union () const
+  {
+    hb_mask_t mask = 0;
+    for (unsigned int i = 0; i < len; i++)
+      mask |= info[i].mask;
+    return mask;
+  }
+
   void reverse_range (unsigned start, unsigned end)
   {
     hb_array_t<hb_glyph_info_t> (info, len).reverse (start, end);
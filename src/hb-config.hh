@@ -82,6 +82,7 @@
 #define HB_NO_SETLOCALE
 #define HB_NO_OT_FONT_GLYPH_NAMES
 #define HB_NO_OT_SHAPE_FRACTIONS
+#define HB_NO_OT_SHAPE_SIMPLE
 #define HB_NO_STYLE
 #define HB_NO_SUBSET_LAYOUT
 #define HB_NO_VAR
@@ -174,6 +175,10 @@
 #endif
 
 #ifdef HB_OPTIMIZE_SIZE
+#define HB_NO_OT_CMAP_FLAT
+#define HB_NO_OT_FONT_EXTENTS_CACHE
+#define HB_NO_OT_LAYOUT_COVERAGE_ACCEL
+#define HB_NO_OT_LAYOUT_FUSE_SINGLE_SUBSTS
 #define HB_NO_OT_LAYOUT_LOOKUP_CACHE
 #endif
 
@@ -134,6 +134,10 @@ hb_face_create_for_tables (hb_reference_table_func_t  reference_table_func,
 
   face->num_glyphs = -1;
 
+  face->shape_plans.init ();
+  face->h_advance_caches.init ();
+  face->v_advance_caches.init ();
+
   face->data.init0 (face);
   face->table.init0 (face);
 
@@ -141,6 +145,93 @@ hb_face_create_for_tables (hb_reference_table_func_t  reference_table_func,
 }
 
 
+
+/*
+ * hb_ot_font_advance_caches_t
+ */
+
+void
+hb_ot_font_advance_caches_t::init ()
+{
+  lock.init ();
+  slots.init ();
+}
+
+void
+hb_ot_font_advance_caches_t::fini ()
+{
+  for (slot_t *slot : slots)
+  {
+    slot->~slot_t ();
+    hb_free (slot);
+  }
+  slots.fini ();
+  lock.fini ();
+}
+
+hb_ot_font_advance_cache_t *
+hb_ot_font_advance_caches_t::acquire (const int *coords, unsigned int num_coords)
+{
+  /* Trailing zeros do not change the instance. */
+  while (num_coords && !coords[num_coords - 1])
+    num_coords--;
+  hb_array_t<const int> key (coords, num_coords);
+  uint32_t hash = key.hash ();
+
+  hb_lock_t l (lock);
+
+  slot_t *unused = nullptr;
+  for (slot_t *slot : slots)
+  {
+    if (slot->hash == hash && key == slot->coords.as_array ())
+    {
+      slot->refs++;
+      return &slot->cache;
+    }
+    if (!slot->refs && !unused)
+      unused = slot;
+  }
+
+  if (!unused)
+  {
+    if (slots.length >= HB_OT_FONT_ADVANCE_CACHE_SLOTS)
+      return nullptr;
+    unused = (slot_t *) hb_calloc (1, sizeof (slot_t));
+    if (unlikely (!unused))
+      return nullptr;
+    new (unused) slot_t ();
+    if (unlikely (!slots.push (unused)))
+    {
+      unused->~slot_t ();
+      hb_free (unused);
+      return nullptr;
+    }
+  }
+
+  unused->cache.init ();
+  unused->coords.reset ();
+  unused->hash = hb_array_t<const int> ().hash ();
+  if (unlikely (!unused->coords.resize (num_coords)))
+    return nullptr;
+  hb_memcpy (unused->coords.arrayZ, coords, num_coords * sizeof (coords[0]));
+  unused->hash = hash;
+  unused->refs = 1;
+  return &unused->cache;
+}
+
+void
+hb_ot_font_advance_caches_t::release (hb_ot_font_advance_cache_t *cache)
+{
+  hb_lock_t l (lock);
+  for (slot_t *slot : slots)
+    if (&slot->cache == cache)
+    {
+      slot->refs--;
+      return;
+    }
+}
+
+
 typedef struct hb_face_for_data_closure_t {
   hb_blob_t *blob;
   uint16_t  index;
@@ -288,14 +379,6 @@ hb_face_destroy (hb_face_t *face)
 {
   if (!hb_object_destroy (face)) return;
 
-  for (hb_face_t::plan_node_t *node = face->shape_plans; node; )
-  {
-    hb_face_t::plan_node_t *next = node->next;
-    hb_shape_plan_destroy (node->shape_plan);
-    hb_free (node);
-    node = next;
-  }
-
   face->data.fini ();
   face->table.fini ();
 
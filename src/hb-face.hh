@@ -31,11 +31,58 @@
 
 #include "hb.hh"
 
+#include "hb-cache.hh"
 #include "hb-shaper.hh"
 #include "hb-shape-plan.hh"
 #include "hb-ot-face.hh"
 
 
+/*
+ * hb_ot_font_advance_caches_t
+ */
+
+#ifndef HB_OT_FONT_ADVANCE_CACHE_BITS
+#define HB_OT_FONT_ADVANCE_CACHE_BITS 8
+#endif
+
+#ifndef HB_OT_FONT_ADVANCE_CACHE_SLOTS
+#define HB_OT_FONT_ADVANCE_CACHE_SLOTS 8
+#endif
+
+/* Unscaled advances by glyph; direct-mapped, 1 << HB_OT_FONT_ADVANCE_CACHE_BITS
+ * entries. */
+using hb_ot_font_advance_cache_t = hb_cache_t<24, 16, HB_OT_FONT_ADVANCE_CACHE_BITS, true>;
+
+/* Advance caches of the variable fonts of a face, one per set of normalized
+ * coordinates, such that fonts at the same instance share one.  Up to
+ * HB_OT_FONT_ADVANCE_CACHE_SLOTS are resident; slots that no font refers to
+ * anymore are reused for other coordinates. */
+struct hb_ot_font_advance_caches_t
+{
+  struct slot_t
+  {
+    hb_ot_font_advance_cache_t cache;
+    hb_vector_t<int> coords;
+    uint32_t hash;
+    unsigned int refs;
+  };
+
+  ~hb_ot_font_advance_caches_t () { fini (); }
+
+  HB_INTERNAL void init ();
+  HB_INTERNAL void fini ();
+
+  /* Returns the cache for coords, to be released when done with, or nullptr
+   * if all slots are referenced for other coordinates. */
+  HB_INTERNAL hb_ot_font_advance_cache_t *acquire (const int *coords, unsigned int num_coords);
+  HB_INTERNAL void release (hb_ot_font_advance_cache_t *cache);
+
+  private:
+  hb_mutex_t lock;
+  hb_vector_t<slot_t *> slots;
+};
+
+
 /*
  * hb_face_t
  */
@@ -60,12 +107,9 @@ struct hb_face_t
   hb_ot_face_t table;			/* All the face's tables. */
 
   /* Cache */
-  struct plan_node_t
-  {
-    hb_shape_plan_t *shape_plan;
-    plan_node_t *next;
-  };
-  hb_atomic_ptr_t<plan_node_t> shape_plans;
+  hb_shape_plan_cache_t shape_plans;
+  hb_ot_font_advance_caches_t h_advance_caches;
+  hb_ot_font_advance_caches_t v_advance_caches;
 
   hb_blob_t *reference_table (hb_tag_t tag) const
   {
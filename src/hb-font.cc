@@ -190,9 +190,47 @@ hb_font_get_variation_glyph_default (hb_font_t      *font,
 				     hb_codepoint_t *glyph,
 				     void           *user_data HB_UNUSED)
 {
+  if (font->has_variation_glyphs_func_set ())
+  {
+    return font->get_variation_glyphs (1, &unicode, 0, &variation_selector, 0, glyph, 0);
+  }
   return font->parent->get_variation_glyph (unicode, variation_selector, glyph);
 }
 
+#define hb_font_get_variation_glyphs_nil hb_font_get_variation_glyphs_default
+
+static unsigned int
+hb_font_get_variation_glyphs_default (hb_font_t            *font,
+				      void                 *font_data HB_UNUSED,
+				      unsigned int          count,
+				      const hb_codepoint_t *first_unicode,
+				      unsigned int          unicode_stride,
+				      const hb_codepoint_t *first_variation_selector,
+				      unsigned int          variation_selector_stride,
+				      hb_codepoint_t       *first_glyph,
+				      unsigned int          glyph_stride,
+				      void                 *user_data HB_UNUSED)
+{
+  if (font->has_variation_glyph_func_set ())
+  {
+    for (unsigned int i = 0; i < count; i++)
+    {
+      if (!font->get_variation_glyph (*first_unicode, *first_variation_selector, first_glyph))
+	return i;
+
+      first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
+      first_variation_selector = &StructAtOffsetUnaligned<hb_codepoint_t> (first_variation_selector, variation_selector_stride);
+      first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+    }
+    return count;
+  }
+
+  return font->parent->get_variation_glyphs (count,
+					     first_unicode, unicode_stride,
+					     first_variation_selector, variation_selector_stride,
+					     first_glyph, glyph_stride);
+}
+
 
 static hb_position_t
 hb_font_get_glyph_h_advance_nil (hb_font_t      *font,
@@ -420,6 +458,10 @@ hb_font_get_glyph_extents_default (hb_font_t          *font,
 				   hb_glyph_extents_t *extents,
 				   void               *user_data HB_UNUSED)
 {
+  if (font->has_glyph_extents_batch_func_set ())
+  {
+    return font->get_glyph_extents_batch (1, &glyph, 0, extents, 0);
+  }
   hb_bool_t ret = font->parent->get_glyph_extents (glyph, extents);
   if (ret) {
     font->parent_scale_position (&extents->x_bearing, &extents->y_bearing);
@@ -428,6 +470,45 @@ hb_font_get_glyph_extents_default (hb_font_t          *font,
   return ret;
 }
 
+#define hb_font_get_glyph_extents_batch_nil hb_font_get_glyph_extents_batch_default
+
+static unsigned int
+hb_font_get_glyph_extents_batch_default (hb_font_t            *font,
+					 void                 *font_data HB_UNUSED,
+					 unsigned int          count,
+					 const hb_codepoint_t *first_glyph,
+					 unsigned int          glyph_stride,
+					 hb_glyph_extents_t   *first_extents,
+					 unsigned int          extents_stride,
+					 void                 *user_data HB_UNUSED)
+{
+  if (font->has_glyph_extents_func_set ())
+  {
+    for (unsigned int i = 0; i < count; i++)
+    {
+      if (!font->get_glyph_extents (*first_glyph, first_extents))
+	return i;
+
+      first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+      first_extents = &StructAtOffsetUnaligned<hb_glyph_extents_t> (first_extents, extents_stride);
+    }
+    return count;
+  }
+
+  unsigned int done = font->parent->get_glyph_extents_batch (count,
+							     first_glyph, glyph_stride,
+							     first_extents, extents_stride);
+  /* With a zero stride all glyphs share one record; scale it only once. */
+  unsigned int scaled = extents_stride ? done : hb_min (done, 1u);
+  for (unsigned int i = 0; i < scaled; i++)
+  {
+    font->parent_scale_position (&first_extents->x_bearing, &first_extents->y_bearing);
+    font->parent_scale_distance (&first_extents->width, &first_extents->height);
+    first_extents = &StructAtOffsetUnaligned<hb_glyph_extents_t> (first_extents, extents_stride);
+  }
+  return done;
+}
+
 static hb_bool_t
 hb_font_get_glyph_contour_point_nil (hb_font_t      *font HB_UNUSED,
 				     void           *font_data HB_UNUSED,
@@ -1015,6 +1096,42 @@ hb_font_get_nominal_glyphs (hb_font_t *font,
 				   first_glyph, glyph_stride);
 }
 
+/**
+ * hb_font_get_variation_glyphs:
+ * @font: #hb_font_t to work upon
+ * @count: number of code points to query
+ * @first_unicode: The first Unicode code point to query
+ * @unicode_stride: The stride between successive code points
+ * @first_variation_selector: The first variation-selector code point to query
+ * @variation_selector_stride: The stride between successive variation selectors
+ * @first_glyph: (out): The first glyph ID retrieved
+ * @glyph_stride: The stride between successive glyph IDs
+ *
+ * Fetches the glyph IDs for a sequence of Unicode code points, each
+ * followed by the corresponding variation-selector code point, stopping
+ * at the first pair that has no glyph.  A @variation_selector_stride of
+ * zero uses the same variation selector for all code points.
+ *
+ * Return value: the number of code points processed
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_font_get_variation_glyphs (hb_font_t *font,
+			      unsigned int count,
+			      const hb_codepoint_t *first_unicode,
+			      unsigned int unicode_stride,
+			      const hb_codepoint_t *first_variation_selector,
+			      unsigned int variation_selector_stride,
+			      hb_codepoint_t *first_glyph,
+			      unsigned int glyph_stride)
+{
+  return font->get_variation_glyphs (count,
+				     first_unicode, unicode_stride,
+				     first_variation_selector, variation_selector_stride,
+				     first_glyph, glyph_stride);
+}
+
 /**
  * hb_font_get_variation_glyph:
  * @font: #hb_font_t to work upon
@@ -1244,6 +1361,36 @@ hb_font_get_glyph_extents (hb_font_t          *font,
   return font->get_glyph_extents (glyph, extents);
 }
 
+/**
+ * hb_font_get_glyph_extents_batch:
+ * @font: #hb_font_t to work upon
+ * @count: The number of glyph IDs in the sequence queried
+ * @first_glyph: The first glyph ID to query
+ * @glyph_stride: The stride between successive glyph IDs
+ * @first_extents: (out): The first #hb_glyph_extents_t retrieved
+ * @extents_stride: The stride between successive extents
+ *
+ * Fetches the #hb_glyph_extents_t data for a sequence of glyph IDs in
+ * the specified font, stopping at the first glyph that has no extents.
+ * The extents of that glyph and all following it are zeroed.
+ *
+ * Return value: the number of glyphs processed
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_font_get_glyph_extents_batch (hb_font_t *font,
+				 unsigned int count,
+				 const hb_codepoint_t *first_glyph,
+				 unsigned int glyph_stride,
+				 hb_glyph_extents_t *first_extents,
+				 unsigned int extents_stride)
+{
+  return font->get_glyph_extents_batch (count,
+					first_glyph, glyph_stride,
+					first_extents, extents_stride);
+}
+
 /**
  * hb_font_get_glyph_contour_point:
  * @font: #hb_font_t to work upon
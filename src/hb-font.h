@@ -258,6 +258,40 @@ typedef unsigned int (*hb_font_get_nominal_glyphs_func_t) (hb_font_t *font, void
 							   unsigned int glyph_stride,
 							   void *user_data);
 
+/**
+ * hb_font_get_variation_glyphs_func_t:
+ * @font: #hb_font_t to work upon
+ * @font_data: @font user data pointer
+ * @count: number of code points to query
+ * @first_unicode: The first Unicode code point to query
+ * @unicode_stride: The stride between successive code points
+ * @first_variation_selector: The first variation-selector code point to query
+ * @variation_selector_stride: The stride between successive variation selectors
+ * @first_glyph: (out): The first glyph ID retrieved
+ * @glyph_stride: The stride between successive glyph IDs
+ * @user_data: User data pointer passed by the caller
+ *
+ * A virtual method for the #hb_font_funcs_t of an #hb_font_t object.
+ *
+ * This method should retrieve the glyph IDs for a sequence of Unicode
+ * code points, each followed by the corresponding variation-selector
+ * code point. Glyph IDs must be returned in a #hb_codepoint_t output
+ * parameter. Processing stops at the first pair that has no glyph.
+ *
+ * Return value: the number of code points processed
+ *
+ * Since: REPLACEME
+ **/
+typedef unsigned int (*hb_font_get_variation_glyphs_func_t) (hb_font_t *font, void *font_data,
+							     unsigned int count,
+							     const hb_codepoint_t *first_unicode,
+							     unsigned int unicode_stride,
+							     const hb_codepoint_t *first_variation_selector,
+							     unsigned int variation_selector_stride,
+							     hb_codepoint_t *first_glyph,
+							     unsigned int glyph_stride,
+							     void *user_data);
+
 /**
  * hb_font_get_glyph_advance_func_t:
  * @font: #hb_font_t to work upon
@@ -442,6 +476,35 @@ typedef hb_bool_t (*hb_font_get_glyph_extents_func_t) (hb_font_t *font, void *fo
 						       hb_glyph_extents_t *extents,
 						       void *user_data);
 
+/**
+ * hb_font_get_glyph_extents_batch_func_t:
+ * @font: #hb_font_t to work upon
+ * @font_data: @font user data pointer
+ * @count: The number of glyph IDs in the sequence queried
+ * @first_glyph: The first glyph ID to query
+ * @glyph_stride: The stride between successive glyph IDs
+ * @first_extents: (out): The first #hb_glyph_extents_t retrieved
+ * @extents_stride: The stride between successive extents
+ * @user_data: User data pointer passed by the caller
+ *
+ * A virtual method for the #hb_font_funcs_t of an #hb_font_t object.
+ *
+ * This method should retrieve the extents for a sequence of glyphs.
+ * Extents must be returned in #hb_glyph_extents output parameters.
+ * Processing stops at the first glyph that has no extents.
+ *
+ * Return value: the number of glyphs processed
+ *
+ * Since: REPLACEME
+ **/
+typedef unsigned int (*hb_font_get_glyph_extents_batch_func_t) (hb_font_t *font, void *font_data,
+								unsigned int count,
+								const hb_codepoint_t *first_glyph,
+								unsigned int glyph_stride,
+								hb_glyph_extents_t *first_extents,
+								unsigned int extents_stride,
+								void *user_data);
+
 /**
  * hb_font_get_glyph_contour_point_func_t:
  * @font: #hb_font_t to work upon
@@ -613,6 +676,22 @@ hb_font_funcs_set_variation_glyph_func (hb_font_funcs_t *ffuncs,
 					hb_font_get_variation_glyph_func_t func,
 					void *user_data, hb_destroy_func_t destroy);
 
+/**
+ * hb_font_funcs_set_variation_glyphs_func:
+ * @ffuncs: A font-function structure
+ * @func: (closure user_data) (destroy destroy) (scope notified): The callback function to assign
+ * @user_data: Data to pass to @func
+ * @destroy: (nullable): The function to call when @user_data is not needed anymore
+ *
+ * Sets the implementation function for #hb_font_get_variation_glyphs_func_t.
+ *
+ * Since: REPLACEME
+ **/
+HB_EXTERN void
+hb_font_funcs_set_variation_glyphs_func (hb_font_funcs_t *ffuncs,
+					 hb_font_get_variation_glyphs_func_t func,
+					 void *user_data, hb_destroy_func_t destroy);
+
 /**
  * hb_font_funcs_set_glyph_h_advance_func:
  * @ffuncs: A font-function structure
@@ -741,6 +820,22 @@ hb_font_funcs_set_glyph_extents_func (hb_font_funcs_t *ffuncs,
 				      hb_font_get_glyph_extents_func_t func,
 				      void *user_data, hb_destroy_func_t destroy);
 
+/**
+ * hb_font_funcs_set_glyph_extents_batch_func:
+ * @ffuncs: A font-function structure
+ * @func: (closure user_data) (destroy destroy) (scope notified): The callback function to assign
+ * @user_data: Data to pass to @func
+ * @destroy: (nullable): The function to call when @user_data is not needed anymore
+ *
+ * Sets the implementation function for #hb_font_get_glyph_extents_batch_func_t.
+ *
+ * Since: REPLACEME
+ **/
+HB_EXTERN void
+hb_font_funcs_set_glyph_extents_batch_func (hb_font_funcs_t *ffuncs,
+					    hb_font_get_glyph_extents_batch_func_t func,
+					    void *user_data, hb_destroy_func_t destroy);
+
 /**
  * hb_font_funcs_set_glyph_contour_point_func:
  * @ffuncs: A font-function structure
@@ -831,6 +926,16 @@ hb_font_get_nominal_glyphs (hb_font_t *font,
 			    hb_codepoint_t *first_glyph,
 			    unsigned int glyph_stride);
 
+HB_EXTERN unsigned int
+hb_font_get_variation_glyphs (hb_font_t *font,
+			      unsigned int count,
+			      const hb_codepoint_t *first_unicode,
+			      unsigned int unicode_stride,
+			      const hb_codepoint_t *first_variation_selector,
+			      unsigned int variation_selector_stride,
+			      hb_codepoint_t *first_glyph,
+			      unsigned int glyph_stride);
+
 HB_EXTERN hb_position_t
 hb_font_get_glyph_h_advance (hb_font_t *font,
 			     hb_codepoint_t glyph);
@@ -871,6 +976,14 @@ hb_font_get_glyph_extents (hb_font_t *font,
 			   hb_codepoint_t glyph,
 			   hb_glyph_extents_t *extents);
 
+HB_EXTERN unsigned int
+hb_font_get_glyph_extents_batch (hb_font_t *font,
+				 unsigned int count,
+				 const hb_codepoint_t *first_glyph,
+				 unsigned int glyph_stride,
+				 hb_glyph_extents_t *first_extents,
+				 unsigned int extents_stride);
+
 HB_EXTERN hb_bool_t
 hb_font_get_glyph_contour_point (hb_font_t *font,
 				 hb_codepoint_t glyph, unsigned int point_index,
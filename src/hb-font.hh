@@ -58,6 +58,8 @@
   HB_FONT_FUNC_IMPLEMENT (glyph_name) \
   HB_FONT_FUNC_IMPLEMENT (glyph_from_name) \
   HB_FONT_FUNC_IMPLEMENT (glyph_shape) \
+  HB_FONT_FUNC_IMPLEMENT (variation_glyphs) \
+  HB_FONT_FUNC_IMPLEMENT (glyph_extents_batch) \
   /* ^--- Add new callbacks here */
 
 struct hb_font_funcs_t
@@ -256,6 +258,21 @@ struct hb_font_t
 					 unicode, variation_selector, glyph,
 					 !klass->user_data ? nullptr : klass->user_data->variation_glyph);
   }
+  unsigned int get_variation_glyphs (unsigned int count,
+				     const hb_codepoint_t *first_unicode,
+				     unsigned int unicode_stride,
+				     const hb_codepoint_t *first_variation_selector,
+				     unsigned int variation_selector_stride,
+				     hb_codepoint_t *first_glyph,
+				     unsigned int glyph_stride)
+  {
+    return klass->get.f.variation_glyphs (this, user_data,
+					  count,
+					  first_unicode, unicode_stride,
+					  first_variation_selector, variation_selector_stride,
+					  first_glyph, glyph_stride,
+					  !klass->user_data ? nullptr : klass->user_data->variation_glyphs);
+  }
 
   hb_position_t get_glyph_h_advance (hb_codepoint_t glyph)
   {
@@ -348,6 +365,24 @@ struct hb_font_t
 				       extents,
 				       !klass->user_data ? nullptr : klass->user_data->glyph_extents);
   }
+  unsigned int get_glyph_extents_batch (unsigned int count,
+					const hb_codepoint_t *first_glyph,
+					unsigned int glyph_stride,
+					hb_glyph_extents_t *first_extents,
+					unsigned int extents_stride)
+  {
+    hb_glyph_extents_t *extents = first_extents;
+    for (unsigned int i = 0; i < count; i++)
+    {
+      memset (extents, 0, sizeof (*extents));
+      extents = &StructAtOffsetUnaligned<hb_glyph_extents_t> (extents, extents_stride);
+    }
+    return klass->get.f.glyph_extents_batch (this, user_data,
+					     count,
+					     first_glyph, glyph_stride,
+					     first_extents, extents_stride,
+					     !klass->user_data ? nullptr : klass->user_data->glyph_extents_batch);
+  }
 
   hb_bool_t get_glyph_contour_point (hb_codepoint_t glyph, unsigned int point_index,
 				     hb_position_t *x, hb_position_t *y)
@@ -421,6 +421,34 @@ hb_ft_get_variation_glyph (hb_font_t *font HB_UNUSED,
   return true;
 }
 
+static unsigned int
+hb_ft_get_variation_glyphs (hb_font_t *font HB_UNUSED,
+			    void *font_data,
+			    unsigned int count,
+			    const hb_codepoint_t *first_unicode,
+			    unsigned int unicode_stride,
+			    const hb_codepoint_t *first_variation_selector,
+			    unsigned int variation_selector_stride,
+			    hb_codepoint_t *first_glyph,
+			    unsigned int glyph_stride,
+			    void *user_data HB_UNUSED)
+{
+  const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
+  hb_lock_t lock (ft_font->lock);
+  unsigned int done;
+  for (done = 0;
+       done < count && (*first_glyph = FT_Face_GetCharVariantIndex (ft_font->ft_face,
+								    *first_unicode,
+								    *first_variation_selector));
+       done++)
+  {
+    first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
+    first_variation_selector = &StructAtOffsetUnaligned<hb_codepoint_t> (first_variation_selector, variation_selector_stride);
+    first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+  }
+  return done;
+}
+
 static void
 hb_ft_get_glyph_h_advances (hb_font_t* font, void* font_data,
 			    unsigned count,
@@ -567,12 +595,15 @@ hb_ft_get_glyph_h_kerning (hb_font_t *font,
 }
 #endif
 
-static hb_bool_t
-hb_ft_get_glyph_extents (hb_font_t *font,
-			 void *font_data,
-			 hb_codepoint_t glyph,
-			 hb_glyph_extents_t *extents,
-			 void *user_data HB_UNUSED)
+static unsigned int
+hb_ft_get_glyph_extents_batch (hb_font_t *font,
+			       void *font_data,
+			       unsigned int count,
+			       const hb_codepoint_t *first_glyph,
+			       unsigned int glyph_stride,
+			       hb_glyph_extents_t *first_extents,
+			       unsigned int extents_stride,
+			       void *user_data HB_UNUSED)
 {
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
   hb_lock_t lock (ft_font->lock);
@@ -593,15 +624,31 @@ hb_ft_get_glyph_extents (hb_font_t *font,
     y_mult = font->y_scale < 0 ? -1 : +1;
   }
 
-  if (unlikely (FT_Load_Glyph (ft_face, glyph, ft_font->load_flags)))
-    return false;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    if (unlikely (FT_Load_Glyph (ft_face, *first_glyph, ft_font->load_flags)))
+      return i;
 
-  extents->x_bearing = (hb_position_t) (x_mult * ft_face->glyph->metrics.horiBearingX);
-  extents->y_bearing = (hb_position_t) (y_mult * ft_face->glyph->metrics.horiBearingY);
-  extents->width  = (hb_position_t) (x_mult *  ft_face->glyph->metrics.width);
-  extents->height = (hb_position_t) (y_mult * -ft_face->glyph->metrics.height);
+    first_extents->x_bearing = (hb_position_t) (x_mult * ft_face->glyph->metrics.horiBearingX);
+    first_extents->y_bearing = (hb_position_t) (y_mult * ft_face->glyph->metrics.horiBearingY);
+    first_extents->width  = (hb_position_t) (x_mult *  ft_face->glyph->metrics.width);
+    first_extents->height = (hb_position_t) (y_mult * -ft_face->glyph->metrics.height);
 
-  return true;
+    first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+    first_extents = &StructAtOffsetUnaligned<hb_glyph_extents_t> (first_extents, extents_stride);
+  }
+
+  return count;
+}
+
+static hb_bool_t
+hb_ft_get_glyph_extents (hb_font_t *font,
+			 void *font_data,
+			 hb_codepoint_t glyph,
+			 hb_glyph_extents_t *extents,
+			 void *user_data)
+{
+  return hb_ft_get_glyph_extents_batch (font, font_data, 1, &glyph, 0, extents, 0, user_data);
 }
 
 static hb_bool_t
@@ -815,6 +862,7 @@ static struct hb_ft_font_funcs_lazy_loader_t : hb_font_funcs_lazy_loader_t<hb_ft
     hb_font_funcs_set_nominal_glyph_func (funcs, hb_ft_get_nominal_glyph, nullptr, nullptr);
     hb_font_funcs_set_nominal_glyphs_func (funcs, hb_ft_get_nominal_glyphs, nullptr, nullptr);
     hb_font_funcs_set_variation_glyph_func (funcs, hb_ft_get_variation_glyph, nullptr, nullptr);
+    hb_font_funcs_set_variation_glyphs_func (funcs, hb_ft_get_variation_glyphs, nullptr, nullptr);
 
     hb_font_funcs_set_font_h_extents_func (funcs, hb_ft_get_font_h_extents, nullptr, nullptr);
     hb_font_funcs_set_glyph_h_advances_func (funcs, hb_ft_get_glyph_h_advances, nullptr, nullptr);
@@ -831,6 +879,7 @@ static struct hb_ft_font_funcs_lazy_loader_t : hb_font_funcs_lazy_loader_t<hb_ft
 #endif
     //hb_font_funcs_set_glyph_v_kerning_func (funcs, hb_ft_get_glyph_v_kerning, nullptr, nullptr);
     hb_font_funcs_set_glyph_extents_func (funcs, hb_ft_get_glyph_extents, nullptr, nullptr);
+    hb_font_funcs_set_glyph_extents_batch_func (funcs, hb_ft_get_glyph_extents_batch, nullptr, nullptr);
     hb_font_funcs_set_glyph_contour_point_func (funcs, hb_ft_get_glyph_contour_point, nullptr, nullptr);
     hb_font_funcs_set_glyph_name_func (funcs, hb_ft_get_glyph_name, nullptr, nullptr);
     hb_font_funcs_set_glyph_from_name_func (funcs, hb_ft_get_glyph_from_name, nullptr, nullptr);
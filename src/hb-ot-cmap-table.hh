@@ -38,6 +38,13 @@
  */
 #define HB_OT_TAG_cmap HB_TAG('c','m','a','p')
 
+#ifndef HB_OT_CMAP_FLAT_THRESHOLD
+#define HB_OT_CMAP_FLAT_THRESHOLD 1024
+#endif
+#ifndef HB_OT_CMAP_FLAT_MAX_PAGES
+#define HB_OT_CMAP_FLAT_MAX_PAGES 512
+#endif
+
 namespace OT {
 
 
@@ -1778,14 +1785,33 @@ struct cmap
 	  break;
 	}
 	}
+#ifndef HB_NO_OT_CMAP_FLAT
+	if (subtable->u.format == 4 || subtable->u.format == 12)
+	  this->flat_budget.set_relaxed (HB_OT_CMAP_FLAT_THRESHOLD);
+#endif
+      }
+    }
+    ~accelerator_t ()
+    {
+#ifndef HB_NO_OT_CMAP_FLAT
+      flat_t *flat = this->flat.get_relaxed ();
+      if (flat)
+      {
+	flat->fini ();
+	hb_free (flat);
       }
+#endif
+      this->table.destroy ();
     }
-    ~accelerator_t () { this->table.destroy (); }
 
     bool get_nominal_glyph (hb_codepoint_t  unicode,
 			    hb_codepoint_t *glyph) const
     {
       if (unlikely (!this->get_glyph_funcZ)) return false;
+#ifndef HB_NO_OT_CMAP_FLAT
+      if (const flat_t *flat = this->flat.get_acquire ())
+	return get_glyph_flat (flat, unicode, glyph);
+#endif
       return this->get_glyph_funcZ (this->get_glyph_data, unicode, glyph);
     }
     unsigned int get_nominal_glyphs (unsigned int count,
@@ -1796,6 +1822,24 @@ struct cmap
     {
       if (unlikely (!this->get_glyph_funcZ)) return 0;
 
+#ifndef HB_NO_OT_CMAP_FLAT
+      const flat_t *flat = this->flat.get_acquire ();
+      if (!flat)
+	flat = get_flat (count);
+      if (flat)
+      {
+	unsigned int done;
+	for (done = 0;
+	     done < count && get_glyph_flat (flat, *first_unicode, first_glyph);
+	     done++)
+	{
+	  first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
+	  first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+	}
+	return done;
+      }
+#endif
+
       hb_cmap_get_glyph_func_t get_glyph_funcZ = this->get_glyph_funcZ;
       const void *get_glyph_data = this->get_glyph_data;
 
@@ -1867,6 +1911,151 @@ struct cmap
       return false;
     }
 
+#ifndef HB_NO_OT_CMAP_FLAT
+    /* The mapping of a format 4 or 12 subtable, flattened into native-endian
+     * pages of 256 glyph ids, indexed by codepoint >> 8.  Page 0 is empty
+     * and shared by all blocks that map nothing. */
+    struct flat_t
+    {
+      void fini ()
+      {
+	pages.fini ();
+	glyphs.fini ();
+      }
+
+      hb_vector_t<uint16_t> pages;
+      hb_vector_t<uint16_t> glyphs;
+    };
+
+    bool get_glyph_flat (const flat_t *flat,
+			 hb_codepoint_t codepoint,
+			 hb_codepoint_t *glyph) const
+    {
+      unsigned block = codepoint >> 8;
+      if (unlikely (block >= flat->pages.length))
+	/* Only subtables mapping past Unicode reach here with a match. */
+	return codepoint > HB_UNICODE_MAX &&
+	       this->get_glyph_funcZ (this->get_glyph_data, codepoint, glyph);
+
+      hb_codepoint_t gid = flat->glyphs.arrayZ[flat->pages.arrayZ[block] * 256 + (codepoint & 0xFF)];
+      if (!gid)
+	return false;
+      *glyph = gid;
+      return true;
+    }
+
+    /* Counts down count lookups, and flattens the subtable once enough were
+     * made that it pays off.  Only ever tries once. */
+    const flat_t *get_flat (unsigned int count) const
+    {
+      int budget = this->flat_budget.get_relaxed ();
+      if (budget <= 0)
+	return nullptr;
+      if (budget > (int) count)
+      {
+	this->flat_budget.set_relaxed (budget - (int) count);
+	return nullptr;
+      }
+      this->flat_budget.set_relaxed (0);
+
+      flat_t *flat = create_flat ();
+      if (unlikely (!flat))
+	return nullptr;
+      if (unlikely (!this->flat.cmpexch (nullptr, flat)))
+      {
+	flat->fini ();
+	hb_free (flat);
+	return this->flat.get_acquire ();
+      }
+      return flat;
+    }
+
+    flat_t *create_flat () const
+    {
+      /* Every codepoint the subtable can map is in one of its ranges; the
+       * glyphs themselves come from the regular lookup, so the flattened
+       * mapping matches it even for overlapping or unsorted ranges. */
+      hb_set_t ranges;
+      if (subtable->u.format == 4)
+      {
+	const CmapSubtableFormat4::accelerator_t &accel = this->format4_accel;
+	for (unsigned i = 0; i < accel.segCount; i++)
+	  if (accel.startCount[i] <= accel.endCount[i])
+	    ranges.add_range (accel.startCount[i], accel.endCount[i]);
+      }
+      else
+      {
+	for (const CmapSubtableLongGroup &group : subtable->u.format12.groups)
+	  if (group.startCharCode <= group.endCharCode &&
+	      group.startCharCode <= HB_UNICODE_MAX)
+	    ranges.add_range (group.startCharCode,
+			      hb_min ((hb_codepoint_t) group.endCharCode,
+				      (hb_codepoint_t) HB_UNICODE_MAX));
+      }
+      if (unlikely (ranges.in_error () || ranges.is_empty ()))
+	return nullptr;
+
+      /* Bound the memory by the blocks the ranges touch, before looking
+       * anything up. */
+      unsigned num_pages = 0;
+      hb_codepoint_t first = HB_SET_VALUE_INVALID, last = HB_SET_VALUE_INVALID;
+      hb_codepoint_t last_block = HB_SET_VALUE_INVALID;
+      while (ranges.next_range (&first, &last))
+      {
+	hb_codepoint_t first_block = first >> 8;
+	if (first_block == last_block)
+	  first_block++;
+	if (first_block <= last >> 8)
+	  num_pages += (last >> 8) - first_block + 1;
+	last_block = last >> 8;
+	if (num_pages > HB_OT_CMAP_FLAT_MAX_PAGES)
+	  return nullptr;
+      }
+
+      flat_t *flat = (flat_t *) hb_calloc (1, sizeof (flat_t));
+      if (unlikely (!flat))
+	return nullptr;
+
+      if (unlikely (!flat->pages.resize (last_block + 1) ||
+		    !flat->glyphs.resize (256)))
+      {
+	flat->fini ();
+	hb_free (flat);
+	return nullptr;
+      }
+
+      first = last = HB_SET_VALUE_INVALID;
+      while (ranges.next_range (&first, &last))
+	for (hb_codepoint_t u = first; u <= last; u++)
+	{
+	  hb_codepoint_t gid;
+	  if (!this->get_glyph_funcZ (this->get_glyph_data, u, &gid))
+	    continue;
+	  if (unlikely (gid > 0xFFFFu))
+	  {
+	    flat->fini ();
+	    hb_free (flat);
+	    return nullptr;
+	  }
+
+	  uint16_t &page = flat->pages.arrayZ[u >> 8];
+	  if (!page)
+	  {
+	    page = flat->glyphs.length / 256;
+	    if (unlikely (!flat->glyphs.resize (flat->glyphs.length + 256)))
+	    {
+	      flat->fini ();
+	      hb_free (flat);
+	      return nullptr;
+	    }
+	  }
+	  flat->glyphs.arrayZ[page * 256 + (u & 0xFF)] = gid;
+	}
+
+      return flat;
+    }
+#endif
+
     private:
     hb_nonnull_ptr_t<const CmapSubtable> subtable;
     hb_nonnull_ptr_t<const CmapSubtableFormat14> subtable_uvs;
@@ -1876,6 +2065,11 @@ struct cmap
 
     CmapSubtableFormat4::accelerator_t format4_accel;
 
+#ifndef HB_NO_OT_CMAP_FLAT
+    mutable hb_atomic_int_t flat_budget;
+    mutable hb_atomic_ptr_t<flat_t> flat;
+#endif
+
     public:
     hb_blob_ptr_t<cmap> table;
   };
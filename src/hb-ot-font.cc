@@ -58,15 +58,129 @@
  * never need to call these functions directly.
  **/
 
-using hb_ot_font_advance_cache_t = hb_cache_t<24, 16, 8, true>;
+/* Scaled y origins by glyph, biased by 1 << 23. */
+using hb_ot_font_origin_cache_t = hb_cache_t<16, 24, 8, true>;
+
+#ifndef HB_NO_OT_FONT_EXTENTS_CACHE
+#ifndef HB_OT_FONT_EXTENTS_CACHE_BITS
+#define HB_OT_FONT_EXTENTS_CACHE_BITS 9
+#endif
+
+/* Scaled glyph extents, direct-mapped by glyph and tagged with the font
+ * serial they were computed at.  Each entry is a seqlock: a reader that
+ * races a writer misses, and a writer that races another one skips the
+ * entry, so neither ever waits.  Sized to the glyph count of the face, up
+ * to 1 << HB_OT_FONT_EXTENTS_CACHE_BITS entries. */
+struct hb_ot_font_extents_cache_t
+{
+  struct entry_t
+  {
+    hb_atomic_int_t seq; /* Odd while being written. */
+    hb_atomic_int_t writers;
+    hb_atomic_int_t glyph;
+    hb_atomic_int_t serial;
+    hb_atomic_int_t x_bearing;
+    hb_atomic_int_t y_bearing;
+    hb_atomic_int_t width;
+    hb_atomic_int_t height;
+  };
+
+  static hb_ot_font_extents_cache_t *create (unsigned num_glyphs)
+  {
+    unsigned bits = hb_min (hb_bit_storage (num_glyphs ? num_glyphs - 1 : 0),
+			    (unsigned) HB_OT_FONT_EXTENTS_CACHE_BITS);
+    unsigned size = 1u << bits;
+
+    hb_ot_font_extents_cache_t *cache = (hb_ot_font_extents_cache_t *)
+      hb_calloc (1, sizeof (hb_ot_font_extents_cache_t) + size * sizeof (entry_t));
+    if (unlikely (!cache))
+      return nullptr;
+
+    cache->mask = size - 1;
+    cache->entries = (entry_t *) (cache + 1);
+    for (unsigned i = 0; i < size; i++)
+      cache->entries[i].glyph.set_relaxed (-1);
+    return cache;
+  }
+
+  bool get (hb_codepoint_t glyph, unsigned serial, hb_glyph_extents_t *extents) const
+  {
+    const entry_t &e = entries[glyph & mask];
+    int seq = e.seq.get_acquire ();
+    if ((seq & 1) ||
+	e.glyph.get_acquire () != (int) glyph ||
+	e.serial.get_acquire () != (int) serial)
+      return false;
+    hb_glyph_extents_t v;
+    v.x_bearing = e.x_bearing.get_acquire ();
+    v.y_bearing = e.y_bearing.get_acquire ();
+    v.width = e.width.get_acquire ();
+    v.height = e.height.get_acquire ();
+    if (e.seq.get_relaxed () != seq)
+      return false;
+    *extents = v;
+    return true;
+  }
+
+  void set (hb_codepoint_t glyph, unsigned serial, const hb_glyph_extents_t &extents)
+  {
+    entry_t &e = entries[glyph & mask];
+    if (e.writers.inc ())
+    {
+      e.writers.dec ();
+      return;
+    }
+    int seq = e.seq.get_relaxed ();
+    e.seq.set_release (seq + 1);
+    e.glyph.set_release (glyph);
+    e.serial.set_release (serial);
+    e.x_bearing.set_release (extents.x_bearing);
+    e.y_bearing.set_release (extents.y_bearing);
+    e.width.set_release (extents.width);
+    e.height.set_release (extents.height);
+    e.seq.set_release (seq + 2);
+    e.writers.dec ();
+  }
+
+  unsigned mask;
+  entry_t *entries;
+  /* Misses are counted on the slow path, next to loading the glyph.  Hits
+   * are on the fast path, where a shared counter would be written by every
+   * thread using the font, so they are only counted on request. */
+#ifdef HB_OT_FONT_EXTENTS_CACHE_STATS
+  hb_atomic_int_t hits;
+#endif
+  hb_atomic_int_t misses;
+};
+#endif
 
 struct hb_ot_font_t
 {
   const hb_ot_face_t *ot_face;
 
-  /* h_advance caching */
-  mutable hb_atomic_int_t cached_coords_serial;
-  mutable hb_atomic_ptr_t<hb_ot_font_advance_cache_t> advance_cache;
+  /* Advance caching; see _hb_ot_font_get_advance_cache(). */
+  struct advance_cache_t
+  {
+    mutable hb_atomic_int_t coords_serial;
+    mutable hb_atomic_ptr_t<hb_ot_font_advance_cache_t> cache;
+    /* The face cache is shared from, or nullptr if cache is own. */
+    mutable hb_face_t *face;
+    mutable hb_ot_font_advance_cache_t *own;
+  };
+  advance_cache_t h_advances;
+#ifndef HB_NO_VERTICAL
+  advance_cache_t v_advances;
+
+  /* v_origin caching */
+  mutable hb_atomic_int_t origin_serial;
+  mutable hb_atomic_ptr_t<hb_ot_font_origin_cache_t> origin_cache;
+#endif
+
+#ifndef HB_NO_OT_FONT_EXTENTS_CACHE
+  mutable hb_atomic_ptr_t<hb_ot_font_extents_cache_t> extents_cache;
+#endif
+
+  mutable hb_mutex_t lock;
 };
 
 static hb_ot_font_t *
@@ -77,25 +191,115 @@ _hb_ot_font_create (hb_font_t *font)
     return nullptr;
 
   ot_font->ot_face = &font->face->table;
+  ot_font->lock.init ();
 
   return ot_font;
 }
 
+static void
+_hb_ot_font_release_advance_cache (const hb_ot_font_t::advance_cache_t &advances,
+				   bool vertical)
+{
+  if (advances.face)
+  {
+    hb_ot_font_advance_caches_t &caches = vertical ? advances.face->v_advance_caches
+						   : advances.face->h_advance_caches;
+    caches.release (advances.cache.get_relaxed ());
+    hb_face_destroy (advances.face);
+    advances.face = nullptr;
+  }
+  advances.cache.set_relaxed (nullptr);
+}
+
+static void
+_hb_ot_font_fini_advance_cache (const hb_ot_font_t::advance_cache_t &advances,
+				bool vertical)
+{
+  _hb_ot_font_release_advance_cache (advances, vertical);
+  if (advances.own)
+  {
+    advances.own->fini ();
+    hb_free (advances.own);
+  }
+}
+
 static void
 _hb_ot_font_destroy (void *font_data)
 {
   hb_ot_font_t *ot_font = (hb_ot_font_t *) font_data;
 
-  auto *cache = ot_font->advance_cache.get_relaxed ();
-  if (cache)
+  _hb_ot_font_fini_advance_cache (ot_font->h_advances, false);
+#ifndef HB_NO_VERTICAL
+  _hb_ot_font_fini_advance_cache (ot_font->v_advances, true);
+
+  auto *origin_cache = ot_font->origin_cache.get_relaxed ();
+  if (origin_cache)
   {
-    cache->fini ();
-    hb_free (cache);
+    origin_cache->fini ();
+    hb_free (origin_cache);
   }
+#endif
+#ifndef HB_NO_OT_FONT_EXTENTS_CACHE
+  hb_free (ot_font->extents_cache.get_relaxed ());
+#endif
+  ot_font->lock.fini ();
 
   hb_free (ot_font);
 }
 
+/* Returns the advance cache for the current coordinates of font: the one
+ * the fonts of the face at the same coordinates share if the face has room
+ * for it, or one of the font's own otherwise. */
+static hb_ot_font_advance_cache_t *
+_hb_ot_font_get_advance_cache (hb_font_t *font, const hb_ot_font_t *ot_font,
+			       bool vertical = false)
+{
+  const hb_ot_font_t::advance_cache_t &advances =
+#ifndef HB_NO_VERTICAL
+						  vertical ? ot_font->v_advances :
+#endif
+						  ot_font->h_advances;
+
+  hb_ot_font_advance_cache_t *cache = advances.cache.get_acquire ();
+  if (likely (cache && advances.coords_serial.get_relaxed () == (int) font->serial_coords))
+    return cache;
+
+  hb_lock_t l (ot_font->lock);
+
+  cache = advances.cache.get_relaxed ();
+  if (cache && advances.coords_serial.get_relaxed () == (int) font->serial_coords)
+    return cache;
+
+  _hb_ot_font_release_advance_cache (advances, vertical);
+
+  cache = nullptr;
+  if (hb_object_is_valid (font->face))
+  {
+    hb_ot_font_advance_caches_t &caches = vertical ? font->face->v_advance_caches
+						   : font->face->h_advance_caches;
+    cache = caches.acquire (font->coords, font->num_coords);
+  }
+  if (cache)
+    advances.face = hb_face_reference (font->face);
+  else
+  {
+    cache = advances.own;
+    if (!cache)
+    {
+      cache = (hb_ot_font_advance_cache_t *) hb_malloc (sizeof (hb_ot_font_advance_cache_t));
+      if (unlikely (!cache))
+	return nullptr;
+      advances.own = cache;
+    }
+    cache->init ();
+  }
+
+  advances.coords_serial.set_relaxed (font->serial_coords);
+  /* Publishes coords_serial along; cannot fail under the lock. */
+  advances.cache.cmpexch (nullptr, cache);
+  return cache;
+}
+
 static hb_bool_t
 hb_ot_get_nominal_glyph (hb_font_t *font HB_UNUSED,
 			 void *font_data,
@@ -138,6 +342,33 @@ hb_ot_get_variation_glyph (hb_font_t *font HB_UNUSED,
   return ot_face->cmap->get_variation_glyph (unicode, variation_selector, glyph);
 }
 
+static unsigned int
+hb_ot_get_variation_glyphs (hb_font_t *font HB_UNUSED,
+			    void *font_data,
+			    unsigned int count,
+			    const hb_codepoint_t *first_unicode,
+			    unsigned int unicode_stride,
+			    const hb_codepoint_t *first_variation_selector,
+			    unsigned int variation_selector_stride,
+			    hb_codepoint_t *first_glyph,
+			    unsigned int glyph_stride,
+			    void *user_data HB_UNUSED)
+{
+  const hb_ot_font_t *ot_font = (const hb_ot_font_t *) font_data;
+  const hb_ot_face_t *ot_face = ot_font->ot_face;
+  const OT::cmap_accelerator_t &cmap = *ot_face->cmap;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    if (!cmap.get_variation_glyph (*first_unicode, *first_variation_selector, first_glyph))
+      return i;
+
+    first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
+    first_variation_selector = &StructAtOffsetUnaligned<hb_codepoint_t> (first_variation_selector, variation_selector_stride);
+    first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+  }
+  return count;
+}
+
 static void
 hb_ot_get_glyph_h_advances (hb_font_t* font, void* font_data,
 			    unsigned count,
@@ -165,27 +396,9 @@ hb_ot_get_glyph_h_advances (hb_font_t* font, void* font_data,
   hb_ot_font_advance_cache_t *cache = nullptr;
   if (use_cache)
   {
-  retry:
-    cache = ot_font->advance_cache.get_acquire ();
-    if (unlikely (!cache))
-    {
-      cache = (hb_ot_font_advance_cache_t *) hb_malloc (sizeof (hb_ot_font_advance_cache_t));
-      if (unlikely (!cache))
-      {
-	use_cache = false;
-	goto out;
-      }
-
-      cache->init ();
-      if (unlikely (!ot_font->advance_cache.cmpexch (nullptr, cache)))
-      {
-	hb_free (cache);
-	goto retry;
-      }
-      ot_font->cached_coords_serial.set_release (font->serial_coords);
-    }
+    cache = _hb_ot_font_get_advance_cache (font, ot_font);
+    use_cache = cache;
   }
-  out:
 
   if (!use_cache)
   {
@@ -198,22 +411,16 @@ hb_ot_get_glyph_h_advances (hb_font_t* font, void* font_data,
   }
   else
   { /* Use cache. */
-    if (ot_font->cached_coords_serial.get_acquire () != (int) font->serial_coords)
-    {
-      ot_font->advance_cache->init ();
-      ot_font->cached_coords_serial.set_release (font->serial_coords);
-    }
-
     for (unsigned int i = 0; i < count; i++)
     {
       hb_position_t v;
       unsigned cv;
-      if (ot_font->advance_cache->get (*first_glyph, &cv))
+      if (cache->get (*first_glyph, &cv))
 	v = cv;
       else
       {
         v = hmtx.get_advance_with_var_unscaled (*first_glyph, font, varStore_cache);
-	ot_font->advance_cache->set (*first_glyph, v);
+	cache->set (*first_glyph, v);
       }
       *first_advance = font->em_scale_x (v);
       first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
@@ -245,16 +452,47 @@ hb_ot_get_glyph_v_advances (hb_font_t* font, void* font_data,
 #ifndef HB_NO_VAR
     const OT::VVAR &VVAR = *vmtx.var_table;
     const OT::VariationStore &varStore = &VVAR + VVAR.varStore;
-    OT::VariationStore::cache_t *varStore_cache = font->num_coords ? varStore.create_cache () : nullptr;
+    OT::VariationStore::cache_t *varStore_cache = font->num_coords * count >= 128 ? varStore.create_cache () : nullptr;
+
+    bool use_cache = font->num_coords;
 #else
     OT::VariationStore::cache_t *varStore_cache = nullptr;
+    bool use_cache = false;
 #endif
 
-    for (unsigned int i = 0; i < count; i++)
+    hb_ot_font_advance_cache_t *cache = nullptr;
+    if (use_cache)
     {
-      *first_advance = font->em_scale_y (-(int) vmtx.get_advance_with_var_unscaled (*first_glyph, font, varStore_cache));
-      first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
-      first_advance = &StructAtOffsetUnaligned<hb_position_t> (first_advance, advance_stride);
+      cache = _hb_ot_font_get_advance_cache (font, ot_font, true);
+      use_cache = cache;
+    }
+
+    if (!use_cache)
+    {
+      for (unsigned int i = 0; i < count; i++)
+      {
+	*first_advance = font->em_scale_y (-(int) vmtx.get_advance_with_var_unscaled (*first_glyph, font, varStore_cache));
+	first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+	first_advance = &StructAtOffsetUnaligned<hb_position_t> (first_advance, advance_stride);
+      }
+    }
+    else
+    { /* Use cache. */
+      for (unsigned int i = 0; i < count; i++)
+      {
+	hb_position_t v;
+	unsigned cv;
+	if (cache->get (*first_glyph, &cv))
+	  v = cv;
+	else
+	{
+	  v = vmtx.get_advance_with_var_unscaled (*first_glyph, font, varStore_cache);
+	  cache->set (*first_glyph, v);
+	}
+	*first_advance = font->em_scale_y (-v);
+	first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+	first_advance = &StructAtOffsetUnaligned<hb_position_t> (first_advance, advance_stride);
+      }
     }
 
 #ifndef HB_NO_VAR
@@ -278,18 +516,42 @@ hb_ot_get_glyph_v_advances (hb_font_t* font, void* font_data,
 #endif
 
 #ifndef HB_NO_VERTICAL
-static hb_bool_t
-hb_ot_get_glyph_v_origin (hb_font_t *font,
-			  void *font_data,
-			  hb_codepoint_t glyph,
-			  hb_position_t *x,
-			  hb_position_t *y,
-			  void *user_data HB_UNUSED)
+/* Returns the origin cache for the current state of font; origins are
+ * scaled, so are cached per font, and reset when the font changes. */
+static hb_ot_font_origin_cache_t *
+_hb_ot_font_get_origin_cache (hb_font_t *font, const hb_ot_font_t *ot_font)
 {
-  const hb_ot_font_t *ot_font = (const hb_ot_font_t *) font_data;
-  const hb_ot_face_t *ot_face = ot_font->ot_face;
+  hb_ot_font_origin_cache_t *cache = ot_font->origin_cache.get_acquire ();
+  if (likely (cache && ot_font->origin_serial.get_relaxed () == (int) font->serial))
+    return cache;
 
-  *x = font->get_glyph_h_advance (glyph) / 2;
+  hb_lock_t l (ot_font->lock);
+
+  cache = ot_font->origin_cache.get_relaxed ();
+  if (cache && ot_font->origin_serial.get_relaxed () == (int) font->serial)
+    return cache;
+
+  ot_font->origin_cache.set_relaxed (nullptr);
+  if (!cache)
+  {
+    cache = (hb_ot_font_origin_cache_t *) hb_malloc (sizeof (hb_ot_font_origin_cache_t));
+    if (unlikely (!cache))
+      return nullptr;
+  }
+  cache->init ();
+
+  ot_font->origin_serial.set_relaxed (font->serial);
+  /* Publishes origin_serial along; cannot fail under the lock. */
+  ot_font->origin_cache.cmpexch (nullptr, cache);
+  return cache;
+}
+
+static hb_position_t
+_hb_ot_get_glyph_v_origin_y (hb_font_t *font,
+			     const hb_ot_font_t *ot_font,
+			     hb_codepoint_t glyph)
+{
+  const hb_ot_face_t *ot_face = ot_font->ot_face;
 
   const OT::VORG &VORG = *ot_face->VORG;
   if (VORG.has_data ())
@@ -305,8 +567,7 @@ hb_ot_get_glyph_v_origin (hb_font_t *font,
 				    &delta);
 #endif
 
-    *y = font->em_scalef_y (VORG.get_y_origin (glyph) + delta);
-    return true;
+    return font->em_scalef_y (VORG.get_y_origin (glyph) + delta);
   }
 
   hb_glyph_extents_t extents = {0};
@@ -315,35 +576,77 @@ hb_ot_get_glyph_v_origin (hb_font_t *font,
     const OT::vmtx_accelerator_t &vmtx = *ot_face->vmtx;
     int tsb = 0;
     if (vmtx.get_leading_bearing_with_var_unscaled (font, glyph, &tsb))
-    {
-      *y = extents.y_bearing + font->em_scale_y (tsb);
-      return true;
-    }
+      return extents.y_bearing + font->em_scale_y (tsb);
 
     hb_font_extents_t font_extents;
     font->get_h_extents_with_fallback (&font_extents);
     hb_position_t advance = font_extents.ascender - font_extents.descender;
     int diff = advance - -extents.height;
-    *y = extents.y_bearing + (diff >> 1);
-    return true;
+    return extents.y_bearing + (diff >> 1);
   }
 
   hb_font_extents_t font_extents;
   font->get_h_extents_with_fallback (&font_extents);
-  *y = font_extents.ascender;
+  return font_extents.ascender;
+}
 
+static hb_bool_t
+hb_ot_get_glyph_v_origin (hb_font_t *font,
+			  void *font_data,
+			  hb_codepoint_t glyph,
+			  hb_position_t *x,
+			  hb_position_t *y,
+			  void *user_data HB_UNUSED)
+{
+  const hb_ot_font_t *ot_font = (const hb_ot_font_t *) font_data;
+
+  *x = font->get_glyph_h_advance (glyph) / 2;
+
+  /* VORG lookups are binary searches, and the fallback loads the glyph
+   * outline, with its variations, for the extents. */
+  hb_ot_font_origin_cache_t *cache = _hb_ot_font_get_origin_cache (font, ot_font);
+  unsigned cv;
+  if (cache && cache->get (glyph, &cv))
+  {
+    *y = (int) cv - (1 << 23);
+    return true;
+  }
+
+  *y = _hb_ot_get_glyph_v_origin_y (font, ot_font, glyph);
+  if (cache)
+    cache->set (glyph, (unsigned) *y + (1u << 23)); /* Fails if out of range. */
   return true;
 }
 #endif
 
-static hb_bool_t
-hb_ot_get_glyph_extents (hb_font_t *font,
-			 void *font_data,
-			 hb_codepoint_t glyph,
-			 hb_glyph_extents_t *extents,
-			 void *user_data HB_UNUSED)
+#ifndef HB_NO_OT_FONT_EXTENTS_CACHE
+static hb_ot_font_extents_cache_t *
+_hb_ot_font_get_extents_cache (hb_font_t *font, const hb_ot_font_t *ot_font)
+{
+retry:
+  hb_ot_font_extents_cache_t *cache = ot_font->extents_cache.get_acquire ();
+  if (likely (cache))
+    return cache;
+
+  cache = hb_ot_font_extents_cache_t::create (font->face->get_num_glyphs ());
+  if (unlikely (!cache))
+    return nullptr;
+
+  if (unlikely (!ot_font->extents_cache.cmpexch (nullptr, cache)))
+  {
+    hb_free (cache);
+    goto retry;
+  }
+  return cache;
+}
+#endif
+
+static bool
+_hb_ot_get_glyph_extents (hb_font_t *font,
+			  const hb_ot_font_t *ot_font,
+			  hb_codepoint_t glyph,
+			  hb_glyph_extents_t *extents)
 {
-  const hb_ot_font_t *ot_font = (const hb_ot_font_t *) font_data;
   const hb_ot_face_t *ot_face = ot_font->ot_face;
 
 #if !defined(HB_NO_OT_FONT_BITMAP) && !defined(HB_NO_COLOR)
@@ -360,6 +663,66 @@ hb_ot_get_glyph_extents (hb_font_t *font,
   return false;
 }
 
+static unsigned int
+hb_ot_get_glyph_extents_batch (hb_font_t *font,
+			       void *font_data,
+			       unsigned int count,
+			       const hb_codepoint_t *first_glyph,
+			       unsigned int glyph_stride,
+			       hb_glyph_extents_t *first_extents,
+			       unsigned int extents_stride,
+			       void *user_data HB_UNUSED)
+{
+  const hb_ot_font_t *ot_font = (const hb_ot_font_t *) font_data;
+
+#ifndef HB_NO_OT_FONT_EXTENTS_CACHE
+  /* Extents come from loading the outline, with its variations, or from
+   * running the charstring; they are scaled, so are cached per font. */
+  hb_ot_font_extents_cache_t *cache = _hb_ot_font_get_extents_cache (font, ot_font);
+#endif
+
+  for (unsigned int i = 0; i < count; i++)
+  {
+    hb_codepoint_t glyph = *first_glyph;
+#ifndef HB_NO_OT_FONT_EXTENTS_CACHE
+    if (cache && cache->get (glyph, font->serial, first_extents))
+    {
+#ifdef HB_OT_FONT_EXTENTS_CACHE_STATS
+      cache->hits.inc ();
+#endif
+    }
+    else
+#endif
+    {
+      if (!_hb_ot_get_glyph_extents (font, ot_font, glyph, first_extents))
+      {
+	memset (first_extents, 0, sizeof (*first_extents));
+	return i;
+      }
+#ifndef HB_NO_OT_FONT_EXTENTS_CACHE
+      if (cache)
+      {
+	cache->misses.inc ();
+	cache->set (glyph, font->serial, *first_extents);
+      }
+#endif
+    }
+    first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+    first_extents = &StructAtOffsetUnaligned<hb_glyph_extents_t> (first_extents, extents_stride);
+  }
+  return count;
+}
+
+static hb_bool_t
+hb_ot_get_glyph_extents (hb_font_t *font,
+			 void *font_data,
+			 hb_codepoint_t glyph,
+			 hb_glyph_extents_t *extents,
+			 void *user_data)
+{
+  return hb_ot_get_glyph_extents_batch (font, font_data, 1, &glyph, 0, extents, 0, user_data);
+}
+
 #ifndef HB_NO_OT_FONT_GLYPH_NAMES
 static hb_bool_t
 hb_ot_get_glyph_name (hb_font_t *font HB_UNUSED,
@@ -447,6 +810,7 @@ static struct hb_ot_font_funcs_lazy_loader_t : hb_font_funcs_lazy_loader_t<hb_ot
     hb_font_funcs_set_nominal_glyph_func (funcs, hb_ot_get_nominal_glyph, nullptr, nullptr);
     hb_font_funcs_set_nominal_glyphs_func (funcs, hb_ot_get_nominal_glyphs, nullptr, nullptr);
     hb_font_funcs_set_variation_glyph_func (funcs, hb_ot_get_variation_glyph, nullptr, nullptr);
+    hb_font_funcs_set_variation_glyphs_func (funcs, hb_ot_get_variation_glyphs, nullptr, nullptr);
 
     hb_font_funcs_set_font_h_extents_func (funcs, hb_ot_get_font_h_extents, nullptr, nullptr);
     hb_font_funcs_set_glyph_h_advances_func (funcs, hb_ot_get_glyph_h_advances, nullptr, nullptr);
@@ -463,6 +827,7 @@ static struct hb_ot_font_funcs_lazy_loader_t : hb_font_funcs_lazy_loader_t<hb_ot
 #endif
 
     hb_font_funcs_set_glyph_extents_func (funcs, hb_ot_get_glyph_extents, nullptr, nullptr);
+    hb_font_funcs_set_glyph_extents_batch_func (funcs, hb_ot_get_glyph_extents_batch, nullptr, nullptr);
     //hb_font_funcs_set_glyph_contour_point_func (funcs, hb_ot_get_glyph_contour_point, nullptr, nullptr);
 
 #ifndef HB_NO_OT_FONT_GLYPH_NAMES
@@ -512,6 +877,45 @@ hb_ot_font_set_funcs (hb_font_t *font)
 		     _hb_ot_font_destroy);
 }
 
+/**
+ * hb_ot_font_get_glyph_extents_cache_stats:
+ * @font: #hb_font_t to work upon
+ * @hits: (out) (optional): Number of glyph extents found in the cache
+ * @misses: (out) (optional): Number of glyph extents that had to be computed
+ *
+ * Fetches the counters of the glyph-extents cache of @font, accumulated
+ * since hb_ot_font_set_funcs() was called on it.  If @font does not use the
+ * OpenType font functions, or the cache is compiled out, both are zero.
+ *
+ * Cache hits are only counted if HarfBuzz was built with
+ * `HB_OT_FONT_EXTENTS_CACHE_STATS` defined; otherwise @hits is zero.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_ot_font_get_glyph_extents_cache_stats (hb_font_t    *font,
+					  unsigned int *hits,   /* OUT.  May be NULL. */
+					  unsigned int *misses  /* OUT.  May be NULL. */)
+{
+  if (hits) *hits = 0;
+  if (misses) *misses = 0;
+
+#ifndef HB_NO_OT_FONT_EXTENTS_CACHE
+  if (font->klass != _hb_ot_get_font_funcs ())
+    return;
+
+  const hb_ot_font_t *ot_font = (const hb_ot_font_t *) font->user_data;
+  const hb_ot_font_extents_cache_t *cache = ot_font->extents_cache.get_acquire ();
+  if (!cache)
+    return;
+
+#ifdef HB_OT_FONT_EXTENTS_CACHE_STATS
+  if (hits) *hits = cache->hits.get_relaxed ();
+#endif
+  if (misses) *misses = cache->misses.get_relaxed ();
+#endif
+}
+
 #ifndef HB_NO_VAR
 bool
 _glyf_get_leading_bearing_with_var_unscaled (hb_font_t *font, hb_codepoint_t glyph, bool is_vertical,
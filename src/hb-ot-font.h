@@ -39,6 +39,11 @@ HB_BEGIN_DECLS
 HB_EXTERN void
 hb_ot_font_set_funcs (hb_font_t *font);
 
+HB_EXTERN void
+hb_ot_font_get_glyph_extents_cache_stats (hb_font_t    *font,
+					  unsigned int *hits,   /* OUT.  May be NULL. */
+					  unsigned int *misses  /* OUT.  May be NULL. */);
+
 
 HB_END_DECLS
 
@@ -34,6 +34,7 @@
 #include "hb-open-type.hh"
 #include "hb-set.hh"
 #include "hb-bimap.hh"
+#include "hb-cache.hh"
 
 #include "OT/Layout/Common/Coverage.hh"
 #include "OT/Layout/types.hh"
@@ -80,6 +81,44 @@ using OT::Layout::MediumTypes;
 #define HB_MAX_LOOKUP_VISIT_COUNT	35000
 #endif
 
+#ifndef HB_COVERAGE_ACCEL_MIN_POPULATION
+/*
+ * Coverage tables with fewer glyphs than this are binary-searched
+ * quickly enough, and are not given a coverage bitmap.
+ */
+#define HB_COVERAGE_ACCEL_MIN_POPULATION	32
+#endif
+
+#ifndef HB_COVERAGE_ACCEL_MAX_BYTES
+/* Memory that one coverage bitmap may use. */
+#define HB_COVERAGE_ACCEL_MAX_BYTES	(1 << 20)
+#endif
+
+#ifndef HB_LOOKUP_ACCEL_MAX_BYTES
+/* Memory, per face and table, that the coverage bitmaps and subtable
+ * caches of lookup accelerators may use together. */
+#define HB_LOOKUP_ACCEL_MAX_BYTES	(2 << 20)
+#endif
+
+#ifndef HB_PAIR_POS_ACCEL_MAX_PAIRS
+/* Glyph pairs of a PairPosFormat1 subtable put in hash maps. */
+#define HB_PAIR_POS_ACCEL_MAX_PAIRS	4096
+#endif
+
+#ifndef HB_LIGATURE_ACCEL_MIN_LIGATURES
+/* LigatureSets with fewer ligatures than this are not given a trie. */
+#define HB_LIGATURE_ACCEL_MIN_LIGATURES	4
+#endif
+
+#ifndef HB_FEATURE_VARIATIONS_ACCEL_MAX_CELLS
+/* Combinations of axis intervals that FeatureVariations conditions
+ * are precomputed for; see FeatureVariations::accelerator_t. */
+#define HB_FEATURE_VARIATIONS_ACCEL_MAX_CELLS	4096
+#endif
+
+/* Caches glyph class values; see ClassDef::get_class(). */
+using hb_ot_class_cache_t = hb_cache_t<15, 8, 7>;
+
 
 namespace OT {
 
@@ -2014,6 +2053,17 @@ struct ClassDef
     default:return 0;
     }
   }
+  unsigned int get_class (hb_codepoint_t glyph_id,
+			  hb_ot_class_cache_t *cache) const
+  {
+    unsigned klass;
+    if (cache && cache->get (glyph_id, &klass))
+      return klass;
+    klass = get_class (glyph_id);
+    if (cache)
+      cache->set (glyph_id, klass);
+    return klass;
+  }
 
   template<typename Iterator,
 	   hb_requires (hb_is_sorted_source_of (Iterator, hb_codepoint_t))>
@@ -2224,6 +2274,110 @@ static inline bool ClassDef_serialize (hb_serialize_context_t *c,
 { return (c->start_embed<ClassDef> ()->serialize (c, it)); }
 
 
+/* Takes size bytes out of what is left of *budget, if that many are;
+ * without a budget, there is no limit. */
+static inline bool
+hb_accel_budget_take (hb_atomic_int_t *budget, int size)
+{
+  if (!budget)
+    return true;
+  if (hb_atomic_int_impl_add (&budget->v, -size) >= size)
+    return true;
+  hb_atomic_int_impl_add (&budget->v, size);
+  return false;
+}
+
+/* Gives back bytes taken with hb_accel_budget_take(). */
+static inline void
+hb_accel_budget_give (hb_atomic_int_t *budget, int size)
+{
+  if (budget)
+    hb_atomic_int_impl_add (&budget->v, size);
+}
+
+/* The glyphs of a Coverage table, as a native-endian bitmap over the
+ * range they span. */
+struct hb_coverage_bits_t
+{
+  void init ()
+  {
+    bits = nullptr;
+    first = 0;
+    len = 0;
+  }
+  void fini ()
+  {
+    hb_free (bits);
+    init ();
+  }
+
+  /* Fails, leaving the bitmap empty, if the coverage is malformed, or if
+   * the bitmap would not fit in HB_COVERAGE_ACCEL_MAX_BYTES or in what is
+   * left of *budget bytes.  Otherwise has() agrees with get_coverage(). */
+  bool init (const Coverage &coverage,
+	     hb_atomic_int_t *budget = nullptr)
+  {
+    init ();
+
+    hb_set_t glyphs;
+    if (unlikely (!coverage.collect_coverage (&glyphs) || glyphs.in_error ()))
+      return false;
+    if (glyphs.is_empty ())
+      return true;
+
+    hb_codepoint_t first_ = glyphs.get_min ();
+    unsigned len_ = glyphs.get_max () - first_ + 1;
+    unsigned words = (len_ + 63) / 64;
+    int size = words * sizeof (uint64_t);
+    if (unlikely (size <= 0 || size > HB_COVERAGE_ACCEL_MAX_BYTES))
+      return false;
+    if (!hb_accel_budget_take (budget, size))
+      return false;
+
+    uint64_t *bits_ = (uint64_t *) hb_calloc (words, sizeof (uint64_t));
+    if (unlikely (!bits_))
+    {
+      hb_accel_budget_give (budget, size);
+      return false;
+    }
+    for (hb_codepoint_t g : glyphs)
+    {
+      /* Ranges of a malformed table can make the binary search miss
+       * glyphs that collect_coverage() reports. */
+      if (unlikely (coverage.get_coverage (g) == NOT_COVERED))
+      {
+	hb_free (bits_);
+	hb_accel_budget_give (budget, size);
+	return false;
+      }
+      unsigned i = g - first_;
+      bits_[i / 64] |= 1ULL << (i % 64);
+    }
+
+    bits = bits_;
+    first = first_;
+    len = len_;
+    return true;
+  }
+
+  bool has (hb_codepoint_t g) const
+  {
+    unsigned i = g - first;
+    return i < len && (bits[i / 64] & (1ULL << (i % 64)));
+  }
+
+  bool in_use () const { return bits; }
+
+  /* Bytes that init() took from the budget. */
+  int get_size () const { return bits ? (len + 63) / 64 * sizeof (uint64_t) : 0; }
+
+  private:
+  uint64_t *bits;
+  hb_codepoint_t first;
+  unsigned len;
+};
+
+
 /*
  * Item Variation Store
  */
@@ -2844,6 +2998,13 @@ struct ConditionFormat1
     return filterRangeMinValue <= coord && coord <= filterRangeMaxValue;
   }
 
+  /* Adds the coordinates on its axis at which the condition switches. */
+  void collect_bounds (hb_vector_t<hb_pair_t<unsigned, int>> *bounds) const
+  {
+    bounds->push (hb_pair_t<unsigned, int> (axisIndex, filterRangeMinValue));
+    bounds->push (hb_pair_t<unsigned, int> (axisIndex, filterRangeMaxValue + 1));
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -2869,6 +3030,14 @@ struct Condition
     }
   }
 
+  void collect_bounds (hb_vector_t<hb_pair_t<unsigned, int>> *bounds) const
+  {
+    switch (u.format) {
+    case 1: u.format1.collect_bounds (bounds); return;
+    default:return;
+    }
+  }
+
   Cond_with_Var_flag_t keep_with_variations (hb_collect_feature_substitutes_with_var_context_t *c,
                                              hb_map_t *condition_map /* OUT */) const
   {
@@ -2919,6 +3088,13 @@ struct ConditionSet
     return true;
   }
 
+  void collect_bounds (hb_vector_t<hb_pair_t<unsigned, int>> *bounds) const
+  {
+    unsigned int count = conditions.len;
+    for (unsigned int i = 0; i < count; i++)
+      (this+conditions.arrayZ[i]).collect_bounds (bounds);
+  }
+
   Cond_with_Var_flag_t keep_with_variations (hb_collect_feature_substitutes_with_var_context_t *c) const
   {
     hb_map_t *condition_map = hb_map_create ();
@@ -3220,6 +3396,140 @@ struct FeatureVariations
     return false;
   }
 
+  /* The conditions of all records, compiled into the coordinates on each
+   * axis at which any of them switches.  Which record applies does not
+   * change in between, so it is precomputed for each combination of axis
+   * intervals, and looked up after a binary search on each axis. */
+  struct accelerator_t
+  {
+    void init (const FeatureVariations &table)
+    {
+      axes.init ();
+      cells.init ();
+      if (!build (table))
+      {
+	fini ();
+	axes.init ();
+	cells.init ();
+      }
+    }
+    void fini ()
+    {
+      axes.fini ();
+      cells.fini ();
+    }
+
+    bool in_use () const { return cells.length; }
+
+    /* Adds the records that apply at some coordinates to *indices, and
+     * returns whether no record applies at some. */
+    bool collect_indices (hb_set_t *indices) const
+    {
+      bool not_found = false;
+      for (unsigned int i = 0; i < cells.length; i++)
+	if (cells.arrayZ[i] == NOT_FOUND_INDEX)
+	  not_found = true;
+	else
+	  indices->add (cells.arrayZ[i]);
+      return not_found;
+    }
+
+    bool find_index (const int *coords, unsigned int coord_len,
+		     unsigned int *index) const
+    {
+      unsigned int cell = 0;
+      for (unsigned int i = 0; i < axes.length; i++)
+      {
+	const axis_t &axis = axes.arrayZ[i];
+	int coord = axis.axis_index < coord_len ? coords[axis.axis_index] : 0;
+	/* The number of bounds at or below coord. */
+	unsigned int lo = 0, hi = axis.bounds.length;
+	while (lo < hi)
+	{
+	  unsigned int mid = (lo + hi) / 2;
+	  if (axis.bounds.arrayZ[mid] <= coord)
+	    lo = mid + 1;
+	  else
+	    hi = mid;
+	}
+	cell = cell * (axis.bounds.length + 1) + lo;
+      }
+      *index = cells.arrayZ[cell];
+      return *index != NOT_FOUND_INDEX;
+    }
+
+    private:
+    static int cmp_bounds (const void *pa, const void *pb)
+    {
+      const auto *a = (const hb_pair_t<unsigned, int> *) pa;
+      const auto *b = (const hb_pair_t<unsigned, int> *) pb;
+      if (a->first != b->first)
+	return a->first < b->first ? -1 : 1;
+      return a->second < b->second ? -1 : a->second > b->second ? 1 : 0;
+    }
+
+    bool build (const FeatureVariations &table)
+    {
+      unsigned int count = table.varRecords.len;
+      if (!count)
+	return false;
+
+      hb_vector_t<hb_pair_t<unsigned, int>> bounds;
+      for (unsigned int i = 0; i < count; i++)
+	(&table+table.varRecords.arrayZ[i].conditions).collect_bounds (&bounds);
+      if (unlikely (bounds.in_error ()))
+	return false;
+      bounds.qsort (cmp_bounds);
+
+      unsigned int num_cells = 1;
+      for (unsigned int i = 0; i < bounds.length;)
+      {
+	axis_t *axis = axes.push ();
+	if (unlikely (axes.in_error ()))
+	  return false;
+	axis->axis_index = bounds.arrayZ[i].first;
+	for (; i < bounds.length && bounds.arrayZ[i].first == axis->axis_index; i++)
+	  if (!axis->bounds.length || axis->bounds.tail () != bounds.arrayZ[i].second)
+	    axis->bounds.push (bounds.arrayZ[i].second);
+	if (unlikely (axis->bounds.in_error ()))
+	  return false;
+	num_cells *= axis->bounds.length + 1;
+	if (num_cells > HB_FEATURE_VARIATIONS_ACCEL_MAX_CELLS)
+	  return false;
+      }
+
+      /* Evaluate the records at one point of each cell; the first axis
+       * varies slowest. */
+      hb_vector_t<int> coords;
+      if (unlikely (!cells.resize (num_cells) ||
+		    !coords.resize (axes.length ? axes.tail ().axis_index + 1 : 0)))
+	return false;
+      for (unsigned int cell = 0; cell < num_cells; cell++)
+      {
+	unsigned int rest = cell;
+	for (unsigned int i = axes.length; i--;)
+	{
+	  const axis_t &axis = axes.arrayZ[i];
+	  unsigned int k = rest % (axis.bounds.length + 1);
+	  rest /= axis.bounds.length + 1;
+	  coords.arrayZ[axis.axis_index] = k ? axis.bounds.arrayZ[k - 1] : axis.bounds.arrayZ[0] - 1;
+	}
+	table.find_index (coords.arrayZ, coords.length, &cells.arrayZ[cell]);
+      }
+      return true;
+    }
+
+    struct axis_t
+    {
+      unsigned int axis_index;
+      hb_vector_t<int> bounds; /* Sorted. */
+    };
+    hb_vector_t<axis_t> axes; /* Sorted by axis_index. */
+    hb_vector_t<unsigned int> cells;
+  };
+
+  unsigned int get_record_count () const { return varRecords.len; }
+
   const Feature *find_substitute (unsigned int variations_index,
 				  unsigned int feature_index) const
   {
@@ -441,6 +441,10 @@ struct MarkGlyphSetsFormat1
   bool covers (unsigned int set_index, hb_codepoint_t glyph_id) const
   { return (this+coverage[set_index]).get_coverage (glyph_id) != NOT_COVERED; }
 
+  unsigned get_set_count () const { return coverage.len; }
+  const Coverage &get_set_coverage (unsigned int set_index) const
+  { return this+coverage[set_index]; }
+
   bool subset (hb_subset_context_t *c) const
   {
     TRACE_SUBSET (this);
@@ -494,6 +498,21 @@ struct MarkGlyphSets
     }
   }
 
+  unsigned get_set_count () const
+  {
+    switch (u.format) {
+    case 1: return u.format1.get_set_count ();
+    default:return 0;
+    }
+  }
+  const Coverage &get_set_coverage (unsigned int set_index) const
+  {
+    switch (u.format) {
+    case 1: return u.format1.get_set_coverage (set_index);
+    default:return Null (Coverage);
+    }
+  }
+
   bool subset (hb_subset_context_t *c) const
   {
     TRACE_SUBSET (this);
@@ -858,10 +877,150 @@ struct GDEF
 	hb_blob_destroy (table.get_blob ());
 	table = hb_blob_get_empty ();
       }
+
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_ACCEL
+      /* Lookups that use a mark filtering set check it for each mark
+       * they skip over, so keep the sets as bitmaps.  These are built as
+       * sets are first used, one per Coverage, within
+       * HB_LOOKUP_ACCEL_MAX_BYTES.  Sets that cannot have one are left
+       * to their Coverage. */
+      mark_glyph_set_budget = HB_LOOKUP_ACCEL_MAX_BYTES;
+      const MarkGlyphSets &mark_glyph_sets = table->get_mark_glyph_sets ();
+      unsigned count = mark_glyph_sets.get_set_count ();
+      int size = count * (sizeof (unsigned) + sizeof (hb_atomic_ptr_t<hb_coverage_bits_t>));
+      if (count && hb_accel_budget_take (&mark_glyph_set_budget, size))
+      {
+	hb_hashmap_t<uintptr_t, unsigned> owners;
+	if (likely (mark_glyph_set_owners.resize (count) &&
+		    mark_glyph_set_bits.resize (count)))
+	  for (unsigned i = 0; i < count; i++)
+	  {
+	    uintptr_t coverage = (uintptr_t) &mark_glyph_sets.get_set_coverage (i);
+	    unsigned *owner;
+	    if (owners.has (coverage, &owner))
+	      mark_glyph_set_owners.arrayZ[i] = *owner;
+	    else
+	    {
+	      mark_glyph_set_owners.arrayZ[i] = i;
+	      owners.set (coverage, i);
+	    }
+	  }
+	if (unlikely (mark_glyph_set_owners.in_error () ||
+		      mark_glyph_set_bits.in_error () ||
+		      owners.in_error ()))
+	{
+	  mark_glyph_set_owners.fini ();
+	  mark_glyph_set_bits.fini ();
+	}
+      }
+#endif
+
+      /* Glyph props are set for every glyph before GSUB and for each
+       * glyph it outputs, each time costing up to two ClassDef searches.
+       * Text only uses a few glyphs at a time, so cache them. */
+      if (table->has_glyph_classes ())
+      {
+	glyph_props_cache = (glyph_props_cache_t *) hb_malloc (sizeof (glyph_props_cache_t));
+	if (likely (glyph_props_cache))
+	  glyph_props_cache->init ();
+      }
+    }
+    ~accelerator_t ()
+    {
+      if (glyph_props_cache)
+      {
+	glyph_props_cache->fini ();
+	hb_free (glyph_props_cache);
+      }
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_ACCEL
+      for (unsigned i = 0; i < mark_glyph_set_bits.length; i++)
+      {
+	hb_coverage_bits_t *bits = mark_glyph_set_bits.arrayZ[i].get_relaxed ();
+	if (bits && bits != &Null (hb_coverage_bits_t))
+	{
+	  bits->fini ();
+	  hb_free (bits);
+	}
+      }
+#endif
+      table.destroy ();
+    }
+
+    bool mark_set_covers (unsigned int set_index, hb_codepoint_t glyph_id) const
+    {
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_ACCEL
+      if (set_index < mark_glyph_set_bits.length)
+      {
+	const hb_coverage_bits_t *bits = get_mark_glyph_set_bits (set_index);
+	if (bits->in_use ())
+	  return bits->has (glyph_id);
+      }
+#endif
+      return table->mark_set_covers (set_index, glyph_id);
+    }
+
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_ACCEL
+    private:
+    const hb_coverage_bits_t *get_mark_glyph_set_bits (unsigned int set_index) const
+    {
+      unsigned owner = mark_glyph_set_owners.arrayZ[set_index];
+
+    retry:
+      hb_coverage_bits_t *bits = mark_glyph_set_bits.arrayZ[owner].get_acquire ();
+      if (likely (bits))
+	return bits;
+
+      /* A set whose bitmap cannot be built gets the empty Null one, so
+       * that it is not tried again. */
+      bits = (hb_coverage_bits_t *) hb_malloc (sizeof (hb_coverage_bits_t));
+      if (unlikely (!bits ||
+		    !bits->init (table->get_mark_glyph_sets ().get_set_coverage (owner),
+				 &mark_glyph_set_budget)))
+      {
+	hb_free (bits);
+	bits = const_cast<hb_coverage_bits_t *> (&Null (hb_coverage_bits_t));
+      }
+
+      if (unlikely (!mark_glyph_set_bits.arrayZ[owner].cmpexch (nullptr, bits)))
+      {
+	if (bits != &Null (hb_coverage_bits_t))
+	{
+	  hb_accel_budget_give (&mark_glyph_set_budget, bits->get_size ());
+	  bits->fini ();
+	  hb_free (bits);
+	}
+	goto retry;
+      }
+
+      return bits;
+    }
+    public:
+#endif
+
+    unsigned int get_glyph_props (hb_codepoint_t glyph) const
+    {
+      unsigned int props;
+      if (glyph_props_cache && glyph_props_cache->get (glyph, &props))
+	return props;
+
+      props = table->get_glyph_props (glyph);
+      if (glyph_props_cache)
+	glyph_props_cache->set (glyph, props);
+      return props;
     }
-    ~accelerator_t () { table.destroy (); }
 
     hb_blob_ptr_t<GDEF> table;
+
+    private:
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_ACCEL
+    /* The set whose bitmap each set uses, the first with its Coverage. */
+    hb_vector_t<unsigned> mark_glyph_set_owners;
+    hb_vector_t<hb_atomic_ptr_t<hb_coverage_bits_t>> mark_glyph_set_bits;
+    /* Bytes left for the bitmaps. */
+    mutable hb_atomic_int_t mark_glyph_set_budget;
+#endif
+    using glyph_props_cache_t = hb_cache_t<16, 16, 8, true>;
+    glyph_props_cache_t *glyph_props_cache = nullptr;
   };
 
   void collect_variation_indices (hb_collect_variation_indices_context_t *c) const
@@ -64,6 +64,31 @@ struct hb_have_non_1to1_context_t :
   bool stop_sublookup_iteration (return_t r) const { return r; }
 };
 
+struct hb_collect_single_substs_context_t :
+       hb_dispatch_context_t<hb_collect_single_substs_context_t, bool>
+{
+  template <typename T>
+  auto _dispatch (const T &obj, hb_priority<1>) HB_AUTO_RETURN
+  ( obj.collect_single_substs (this) )
+  template <typename T>
+  bool _dispatch (const T &obj HB_UNUSED, hb_priority<0>) { return false; }
+  template <typename T>
+  return_t dispatch (const T &obj) { return _dispatch (obj, hb_prioritize); }
+  static return_t default_return_value () { return true; }
+  bool stop_sublookup_iteration (return_t r) const { return !r; }
+
+  /* Earlier subtables take precedence, as in apply(). */
+  void add (hb_codepoint_t glyph, hb_codepoint_t substitute)
+  {
+    if (!mapping->has (glyph))
+      mapping->set (glyph, substitute);
+  }
+
+  hb_collect_single_substs_context_t (hb_map_t *mapping_) : mapping (mapping_) {}
+
+  hb_map_t *mapping;
+};
+
 struct hb_closure_context_t :
        hb_dispatch_context_t<hb_closure_context_t>
 {
@@ -532,6 +557,10 @@ struct hb_ot_apply_context_t :
     may_skip (const hb_glyph_info_t &info) const
     { return matcher.may_skip (c, info); }
 
+    matcher_t::may_match_t
+    may_match (hb_glyph_info_t &info, hb_codepoint_t glyph_data) const
+    { return matcher.may_match (info, glyph_data); }
+
     bool next (unsigned *unsafe_to = nullptr)
     {
       assert (num_items > 0);
@@ -669,6 +698,7 @@ struct hb_ot_apply_context_t :
   hb_face_t *face;
   hb_buffer_t *buffer;
   recurse_func_t recurse_func = nullptr;
+  const GDEF_accelerator_t &gdef_accel;
   const GDEF &gdef;
   const VariationStore &var_store;
   VariationStore::cache_t *var_store_cache;
@@ -687,18 +717,28 @@ struct hb_ot_apply_context_t :
   uint32_t random_state = 1;
   unsigned new_syllables = (unsigned) -1;
 
+  /* Over-approximation of the glyphs currently in the buffer; grows as
+   * glyphs are replaced or output, and is never shrunk. */
+  hb_set_digest_t digest;
+
+  /* Union of the masks of the glyphs in the buffer.  Glyphs are output
+   * with the masks of the glyphs they replace, so only pause functions
+   * can set new bits. */
+  hb_mask_t masks;
+
   hb_ot_apply_context_t (unsigned int table_index_,
 			 hb_font_t *font_,
 			 hb_buffer_t *buffer_) :
 			table_index (table_index_),
 			font (font_), face (font->face), buffer (buffer_),
-			gdef (
+			gdef_accel (
 #ifndef HB_NO_OT_LAYOUT
-			      *face->table.GDEF->table
+				    *face->table.GDEF
 #else
-			      Null (GDEF)
+				    Null (GDEF_accelerator_t)
 #endif
-			     ),
+				   ),
+			gdef (*gdef_accel.table),
 			var_store (gdef.get_var_store ()),
 			var_store_cache (
 #ifndef HB_NO_VAR
@@ -708,7 +748,9 @@ struct hb_ot_apply_context_t :
 #endif
 					),
 			direction (buffer_->props.direction),
-			has_glyph_classes (gdef.has_glyph_classes ())
+			has_glyph_classes (gdef.has_glyph_classes ()),
+			digest (buffer_->digest ()),
+			masks (buffer_->mask_union ())
   { init_iters (); }
 
   ~hb_ot_apply_context_t ()
@@ -748,7 +790,7 @@ struct hb_ot_apply_context_t :
      * match_props has the set index.
      */
     if (match_props & LookupFlag::UseMarkFilteringSet)
-      return gdef.mark_set_covers (match_props >> 16, glyph);
+      return gdef_accel.mark_set_covers (match_props >> 16, glyph);
 
     /* The second byte of match_props has the meaning
      * "ignore marks of attachment type different than
@@ -781,8 +823,10 @@ struct hb_ot_apply_context_t :
   void _set_glyph_class (hb_codepoint_t glyph_index,
 			  unsigned int class_guess = 0,
 			  bool ligature = false,
-			  bool component = false) const
+			  bool component = false)
   {
+    digest.add (glyph_index);
+
     if (new_syllables != (unsigned) -1)
       buffer->cur().syllable() = new_syllables;
 
@@ -804,7 +848,7 @@ struct hb_ot_apply_context_t :
     if (likely (has_glyph_classes))
     {
       props &= HB_OT_LAYOUT_GLYPH_PROPS_PRESERVE;
-      _hb_glyph_info_set_glyph_props (&buffer->cur(), props | gdef.get_glyph_props (glyph_index));
+      _hb_glyph_info_set_glyph_props (&buffer->cur(), props | gdef_accel.get_glyph_props (glyph_index));
     }
     else if (class_guess)
     {
@@ -815,24 +859,24 @@ struct hb_ot_apply_context_t :
       _hb_glyph_info_set_glyph_props (&buffer->cur(), props);
   }
 
-  void replace_glyph (hb_codepoint_t glyph_index) const
+  void replace_glyph (hb_codepoint_t glyph_index)
   {
     _set_glyph_class (glyph_index);
     (void) buffer->replace_glyph (glyph_index);
   }
-  void replace_glyph_inplace (hb_codepoint_t glyph_index) const
+  void replace_glyph_inplace (hb_codepoint_t glyph_index)
   {
     _set_glyph_class (glyph_index);
     buffer->cur().codepoint = glyph_index;
   }
   void replace_glyph_with_ligature (hb_codepoint_t glyph_index,
-				    unsigned int class_guess) const
+				    unsigned int class_guess)
   {
     _set_glyph_class (glyph_index, class_guess, true);
     (void) buffer->replace_glyph (glyph_index);
   }
   void output_glyph_for_component (hb_codepoint_t glyph_index,
-				   unsigned int class_guess) const
+				   unsigned int class_guess)
   {
     _set_glyph_class (glyph_index, class_guess, false, true);
     (void) buffer->output_glyph (glyph_index);
@@ -872,10 +916,24 @@ struct hb_accelerate_subtables_context_t :
     const Type *typed_obj = (const Type *) obj;
     return cache_func_ (typed_obj, c, enter, hb_prioritize);
   }
+
+  template <typename Type>
+  static inline bool apply_external_cached_to (const void *obj, OT::hb_ot_apply_context_t *c, void *external_cache)
+  {
+    const Type *typed_obj = (const Type *) obj;
+    return typed_obj->apply (c, (typename Type::external_cache_t *) external_cache);
+  }
+  template <typename Type>
+  static inline void external_cache_destroy_to (void *external_cache, hb_atomic_int_t *budget)
+  {
+    Type::external_cache_destroy ((typename Type::external_cache_t *) external_cache, budget);
+  }
 #endif
 
   typedef bool (*hb_apply_func_t) (const void *obj, OT::hb_ot_apply_context_t *c);
   typedef bool (*hb_cache_func_t) (const void *obj, OT::hb_ot_apply_context_t *c, bool enter);
+  typedef bool (*hb_apply_external_cached_func_t) (const void *obj, OT::hb_ot_apply_context_t *c, void *external_cache);
+  typedef void (*hb_external_cache_destroy_func_t) (void *external_cache, hb_atomic_int_t *budget);
 
   struct hb_applicable_t
   {
@@ -899,16 +957,78 @@ struct hb_accelerate_subtables_context_t :
 #endif
       digest.init ();
       obj_.get_coverage ().collect_coverage (&digest);
+#ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
+      external_cache = nullptr;
+#endif
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_ACCEL
+      coverage_bits.init ();
+#endif
+    }
+    /* Gives back to *budget what the caches took from it. */
+    void fini (hb_atomic_int_t *budget = nullptr)
+    {
+#ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
+      if (external_cache)
+	external_cache_destroy_func (external_cache, budget);
+      external_cache = nullptr;
+#endif
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_ACCEL
+      hb_accel_budget_give (budget, coverage_bits.get_size ());
+      coverage_bits.fini ();
+#endif
+    }
+
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_ACCEL
+    /* For large coverage tables, the digest lets through most glyphs
+     * and the subtable then binary-searches its coverage only to find
+     * that the glyph is not covered.  Give those a native-endian bitmap
+     * of their coverage, within what is left of *budget bytes. */
+    void init_coverage_bits (const Layout::Common::Coverage &coverage,
+			     hb_atomic_int_t *budget)
+    {
+      if (coverage.get_population () < HB_COVERAGE_ACCEL_MIN_POPULATION)
+	return;
+      coverage_bits.init (coverage, budget);
+    }
+#endif
+
+    bool may_apply (hb_codepoint_t g) const
+    {
+      if (!digest.may_have (g))
+	return false;
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_ACCEL
+      if (coverage_bits.in_use ())
+	return coverage_bits.has (g);
+#endif
+      return true;
     }
 
     bool apply (OT::hb_ot_apply_context_t *c) const
     {
-      return digest.may_have (c->buffer->cur().codepoint) && apply_func (obj, c);
+      if (!may_apply (c->buffer->cur().codepoint))
+	return false;
+#ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
+      if (external_cache)
+	return apply_external_cached_func (obj, c, external_cache);
+#endif
+      return apply_func (obj, c);
     }
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
     bool apply_cached (OT::hb_ot_apply_context_t *c) const
     {
-      return digest.may_have (c->buffer->cur().codepoint) &&  apply_cached_func (obj, c);
+      if (!may_apply (c->buffer->cur().codepoint))
+	return false;
+      if (external_cache)
+	return apply_external_cached_func (obj, c, external_cache);
+      return apply_cached_func (obj, c);
+    }
+    void set_external_cache (void *external_cache_,
+			     hb_apply_external_cached_func_t apply_external_cached_func_,
+			     hb_external_cache_destroy_func_t external_cache_destroy_func_)
+    {
+      external_cache = external_cache_;
+      apply_external_cached_func = apply_external_cached_func_;
+      external_cache_destroy_func = external_cache_destroy_func_;
     }
     bool cache_enter (OT::hb_ot_apply_context_t *c) const
     {
@@ -926,8 +1046,16 @@ struct hb_accelerate_subtables_context_t :
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
     hb_apply_func_t apply_cached_func;
     hb_cache_func_t cache_func;
+    /* Owned by the subtable's entry, for values that only depend on
+     * the font; see dispatch(). */
+    void *external_cache;
+    hb_apply_external_cached_func_t apply_external_cached_func;
+    hb_external_cache_destroy_func_t external_cache_destroy_func;
 #endif
     hb_set_digest_t digest;
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_ACCEL
+    hb_coverage_bits_t coverage_bits;
+#endif
   };
 
   typedef hb_vector_t<hb_applicable_t> array_t;
@@ -937,6 +1065,14 @@ struct hb_accelerate_subtables_context_t :
   auto cache_cost (const T &obj, hb_priority<1>) HB_AUTO_RETURN ( obj.cache_cost () )
   template <typename T>
   auto cache_cost (const T &obj, hb_priority<0>) HB_AUTO_RETURN ( 0u )
+
+  template <typename T>
+  auto init_external_cache (hb_applicable_t &entry, const T &obj, hb_atomic_int_t *budget_, hb_priority<1>) HB_AUTO_RETURN
+  ( entry.set_external_cache (obj.external_cache_create (budget_),
+			      apply_external_cached_to<T>,
+			      external_cache_destroy_to<T>) )
+  template <typename T>
+  void init_external_cache (hb_applicable_t &entry HB_UNUSED, const T &obj HB_UNUSED, hb_atomic_int_t *budget_ HB_UNUSED, hb_priority<0>) {}
 #endif
 
   /* Dispatch interface. */
@@ -952,8 +1088,17 @@ struct hb_accelerate_subtables_context_t :
 		, cache_func_to<T>
 #endif
 		);
+#ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
+    init_external_cache (entry, obj, budget, hb_prioritize);
+#endif
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_ACCEL
+    if (budget)
+      entry.init_coverage_bits (obj.get_coverage (), budget);
+#endif
 
     array.push (entry);
+    if (unlikely (array.in_error ()))
+      entry.fini (budget);
 
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
     /* Cache handling
@@ -963,6 +1108,12 @@ struct hb_accelerate_subtables_context_t :
      * because the resources they would use will collide.  As such, we ask
      * each subtable to tell us how much it costs (which a cache would avoid),
      * and we allocate the cache opportunity to the costliest subtable.
+     *
+     * Subtables can additionally keep an external cache, created above,
+     * of values that only depend on the font, like glyph classes.  Those
+     * live with the lookup accelerator rather than in the buffer, so any
+     * number of subtables of a lookup can use one, and they last beyond
+     * one lookup pass.
      */
     unsigned cost = cache_cost (obj, hb_prioritize);
     if (cost > cache_user_cost && !array.in_error ())
@@ -976,10 +1127,14 @@ struct hb_accelerate_subtables_context_t :
   }
   static return_t default_return_value () { return hb_empty_t (); }
 
-  hb_accelerate_subtables_context_t (array_t &array_) :
-				     array (array_) {}
+  hb_accelerate_subtables_context_t (array_t &array_,
+				     hb_atomic_int_t *budget_ = nullptr) :
+				     array (array_),
+				     budget (budget_) {}
 
   array_t &array;
+  /* Bytes left for coverage bitmaps and external caches, if limited. */
+  hb_atomic_int_t *budget;
 
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
   unsigned cache_user_idx = (unsigned) -1;
@@ -1116,6 +1271,11 @@ static inline bool match_coverage (hb_glyph_info_t &info, unsigned value, const
   coverage = value;
   return (data+coverage).get_coverage (info.codepoint) != NOT_COVERED;
 }
+static inline bool match_coverage_bits (hb_glyph_info_t &info, unsigned value, const void *data)
+{
+  const hb_coverage_bits_t *coverages = reinterpret_cast<const hb_coverage_bits_t *>(data);
+  return coverages[value].has (info.codepoint);
+}
 
 template <typename HBUINT>
 static inline bool would_match_input (hb_would_apply_context_t *c,
@@ -3686,11 +3846,106 @@ struct ChainContextFormat3
     return this+input[0];
   }
 
-  bool apply (hb_ot_apply_context_t *c) const
+  /* The subtable compiled for matching: each of its distinct coverages
+   * as a bitmap, and its backtrack, input and lookahead sequences as
+   * indices into those instead of offsets.  Not built if the bitmaps do
+   * not fit in what is left of *budget. */
+  struct external_cache_t
+  {
+    hb_vector_t<hb_coverage_bits_t> coverages;
+    hb_vector_t<HBUINT16> backtrack;
+    hb_vector_t<HBUINT16> input;
+    hb_vector_t<HBUINT16> lookahead;
+  };
+  external_cache_t *external_cache_create (hb_atomic_int_t *budget) const
+  {
+    const auto &input = StructAfter<decltype (inputX)> (backtrack);
+    const auto &lookahead = StructAfter<decltype (lookaheadX)> (input);
+    /* Longer sequences never match, or are not worth it. */
+    if (unlikely (backtrack.len > HB_MAX_CONTEXT_LENGTH ||
+		  input.len > HB_MAX_CONTEXT_LENGTH ||
+		  lookahead.len > HB_MAX_CONTEXT_LENGTH))
+      return nullptr;
+
+    external_cache_t *cache = (external_cache_t *) hb_calloc (1, sizeof (external_cache_t));
+    if (unlikely (!cache))
+      return nullptr;
+    new (cache) external_cache_t ();
+
+    hb_map_t indices;
+    if (!compile_coverages (cache, indices, backtrack, cache->backtrack, budget) ||
+	!compile_coverages (cache, indices, input, cache->input, budget) ||
+	!compile_coverages (cache, indices, lookahead, cache->lookahead, budget))
+    {
+      external_cache_destroy (cache, budget);
+      return nullptr;
+    }
+    return cache;
+  }
+  static void external_cache_destroy (external_cache_t *cache,
+				      hb_atomic_int_t *budget)
+  {
+    for (unsigned i = 0; i < cache->coverages.length; i++)
+    {
+      hb_accel_budget_give (budget, cache->coverages.arrayZ[i].get_size ());
+      cache->coverages.arrayZ[i].fini ();
+    }
+    cache->~external_cache_t ();
+    hb_free (cache);
+  }
+
+  bool compile_coverages (external_cache_t *cache,
+			  hb_map_t &indices,
+			  const Array16OfOffset16To<Coverage> &offsets,
+			  hb_vector_t<HBUINT16> &values,
+			  hb_atomic_int_t *budget) const
+  {
+    if (unlikely (!values.resize (offsets.len)))
+      return false;
+    for (unsigned i = 0; i < offsets.len; i++)
+    {
+      unsigned offset = offsets[i];
+      unsigned index = indices.get (offset);
+      if (index == HB_MAP_VALUE_INVALID)
+      {
+	index = cache->coverages.length;
+	hb_coverage_bits_t *bits = cache->coverages.push ();
+	if (unlikely (cache->coverages.in_error ()))
+	  return false;
+	if (!bits->init (this+offsets[i], budget))
+	  return false;
+	indices.set (offset, index);
+      }
+      values.arrayZ[i] = index;
+    }
+    return !indices.in_error ();
+  }
+
+  bool apply (hb_ot_apply_context_t *c,
+	      external_cache_t *cache = nullptr) const
   {
     TRACE_APPLY (this);
     const auto &input = StructAfter<decltype (inputX)> (backtrack);
 
+    if (cache)
+    {
+      const hb_coverage_bits_t *coverages = cache->coverages.arrayZ;
+      if (likely (!coverages[cache->input.arrayZ[0]].has (c->buffer->cur().codepoint)))
+	return_trace (false);
+
+      const auto &lookahead = StructAfter<decltype (lookaheadX)> (input);
+      const auto &lookup = StructAfter<decltype (lookupX)> (lookahead);
+      struct ChainContextApplyLookupContext lookup_context = {
+	{{match_coverage_bits, match_coverage_bits, match_coverage_bits}},
+	{coverages, coverages, coverages}
+      };
+      return_trace (chain_context_apply_lookup (c,
+						cache->backtrack.length, cache->backtrack.arrayZ,
+						cache->input.length, cache->input.arrayZ + 1,
+						cache->lookahead.length, cache->lookahead.arrayZ,
+						lookup.len, lookup.arrayZ, lookup_context));
+    }
+
     unsigned int index = (this+input[0]).get_coverage (c->buffer->cur().codepoint);
     if (likely (index == NOT_COVERED)) return_trace (false);
 
@@ -3936,13 +4191,30 @@ struct Extension
 struct hb_ot_layout_lookup_accelerator_t
 {
   template <typename TLookup>
-  void init (const TLookup &lookup)
+  static hb_ot_layout_lookup_accelerator_t *create (const TLookup &lookup,
+						     hb_atomic_int_t *budget = nullptr)
+  {
+    hb_ot_layout_lookup_accelerator_t *accel = (hb_ot_layout_lookup_accelerator_t *) hb_calloc (1, sizeof (hb_ot_layout_lookup_accelerator_t));
+    if (unlikely (!accel))
+      return nullptr;
+
+    accel->init (lookup, budget);
+    return accel;
+  }
+
+  template <typename TLookup>
+  void init (const TLookup &lookup,
+	     hb_atomic_int_t *budget = nullptr)
   {
     digest.init ();
     lookup.collect_coverage (&digest);
 
+#ifndef HB_NO_OT_LAYOUT_FUSE_SINGLE_SUBSTS
+    single_substs.init ();
+#endif
+
     subtables.init ();
-    OT::hb_accelerate_subtables_context_t c_accelerate_subtables (subtables);
+    OT::hb_accelerate_subtables_context_t c_accelerate_subtables (subtables, budget);
     lookup.dispatch (&c_accelerate_subtables);
 
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
@@ -3952,11 +4224,26 @@ struct hb_ot_layout_lookup_accelerator_t
 	subtables[i].apply_cached_func = subtables[i].apply_func;
 #endif
   }
-  void fini () { subtables.fini (); }
+  /* Gives back to *budget what the caches took from it. */
+  void fini (hb_atomic_int_t *budget = nullptr)
+  {
+    for (unsigned int i = 0; i < subtables.length; i++)
+      subtables[i].fini (budget);
+    subtables.fini ();
+#ifndef HB_NO_OT_LAYOUT_FUSE_SINGLE_SUBSTS
+    hb_map_t *mapping = single_substs.get_relaxed ();
+    if (mapping && mapping != hb_map_get_empty ())
+      hb_accel_budget_give (budget, get_single_substs_size (mapping));
+    hb_map_destroy (mapping);
+#endif
+  }
 
   bool may_have (hb_codepoint_t g) const
   { return digest.may_have (g); }
 
+  bool may_have (const hb_set_digest_t &glyphs) const
+  { return digest.may_have (glyphs); }
+
   bool apply (hb_ot_apply_context_t *c, bool use_cache) const
   {
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
@@ -3976,6 +4263,48 @@ struct hb_ot_layout_lookup_accelerator_t
     return false;
   }
 
+#ifndef HB_NO_OT_LAYOUT_FUSE_SINGLE_SUBSTS
+  /* For lookups of SingleSubst subtables only, the substitution of each
+   * glyph they substitute, built on first use if the memory it takes is
+   * left of *budget.  hb_ot_map_t::apply() uses those to apply runs of
+   * such lookups in one pass over the buffer. */
+  template <typename TLookup>
+  const hb_map_t *get_single_substs (const TLookup &lookup,
+				     hb_atomic_int_t *budget = nullptr) const
+  {
+  retry:
+    hb_map_t *mapping = single_substs.get_acquire ();
+    if (likely (mapping))
+      return mapping->is_empty () ? nullptr : mapping;
+
+    mapping = hb_map_create ();
+    hb_collect_single_substs_context_t c (mapping);
+    int size = 0;
+    if (likely (lookup.dispatch (&c) && !mapping->in_error ()))
+      size = get_single_substs_size (mapping);
+    if (unlikely (!size || !hb_accel_budget_take (budget, size)))
+    {
+      /* Do not try again. */
+      hb_map_destroy (mapping);
+      mapping = hb_map_get_empty ();
+      size = 0;
+    }
+
+    if (unlikely (!single_substs.cmpexch (nullptr, mapping)))
+    {
+      hb_accel_budget_give (budget, size);
+      hb_map_destroy (mapping);
+      goto retry;
+    }
+    return mapping->is_empty () ? nullptr : mapping;
+  }
+
+  static int get_single_substs_size (const hb_map_t *mapping)
+  {
+    return sizeof (*mapping) + (mapping->mask ? mapping->mask + 1 : 0) * sizeof (hb_map_t::item_t);
+  }
+#endif
+
   bool cache_enter (OT::hb_ot_apply_context_t *c) const
   {
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
@@ -3996,6 +4325,9 @@ struct hb_ot_layout_lookup_accelerator_t
   private:
   hb_set_digest_t digest;
   hb_accelerate_subtables_context_t::array_t subtables;
+#ifndef HB_NO_OT_LAYOUT_FUSE_SINGLE_SUBSTS
+  mutable hb_atomic_ptr_t<hb_map_t> single_substs;
+#endif
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
   unsigned cache_user_idx = (unsigned) -1;
 #endif
@@ -4343,8 +4675,9 @@ struct GSUBGPOS
       }
 
       this->lookup_count = table->get_lookup_count ();
+      this->accel_budget = HB_LOOKUP_ACCEL_MAX_BYTES;
 
-      this->accels = (hb_ot_layout_lookup_accelerator_t *) hb_calloc (this->lookup_count, sizeof (hb_ot_layout_lookup_accelerator_t));
+      this->accels = (hb_atomic_ptr_t<hb_ot_layout_lookup_accelerator_t> *) hb_calloc (this->lookup_count, sizeof (*accels));
       if (unlikely (!this->accels))
       {
 	this->lookup_count = 0;
@@ -4352,20 +4685,85 @@ struct GSUBGPOS
 	this->table = hb_blob_get_empty ();
       }
 
-      for (unsigned int i = 0; i < this->lookup_count; i++)
-	this->accels[i].init (table->get_lookup (i));
+#ifndef HB_NO_VAR
+      this->feature_variations.init (table->get_feature_variations ());
+#endif
     }
     ~accelerator_t ()
     {
       for (unsigned int i = 0; i < this->lookup_count; i++)
-	this->accels[i].fini ();
+      {
+	hb_ot_layout_lookup_accelerator_t *accel = this->accels[i].get_relaxed ();
+	if (accel)
+	  accel->fini ();
+	hb_free (accel);
+      }
       hb_free (this->accels);
+#ifndef HB_NO_VAR
+      this->feature_variations.fini ();
+#endif
       this->table.destroy ();
     }
 
+    bool find_variations_index (const int *coords, unsigned int num_coords,
+				unsigned int *index) const
+    {
+#ifndef HB_NO_VAR
+      if (feature_variations.in_use ())
+	return feature_variations.find_index (coords, num_coords, index);
+#endif
+      return table->find_variations_index (coords, num_coords, index);
+    }
+
+    /* Adds the FeatureVariations records that find_variations_index() finds
+     * at some coordinates to *indices, and returns whether it finds none
+     * at some. */
+    bool collect_variations_indices (hb_set_t *indices) const
+    {
+#ifndef HB_NO_VAR
+      if (feature_variations.in_use ())
+	return feature_variations.collect_indices (indices);
+      unsigned int count = table->get_feature_variations ().get_record_count ();
+      if (count)
+	indices->add_range (0, count - 1);
+#endif
+      return true;
+    }
+
+    /* Lookup accelerators are built on first use, such that faces only
+     * pay for the lookups their scripts use. */
+    hb_ot_layout_lookup_accelerator_t *get_accel (unsigned int lookup_index) const
+    {
+      if (unlikely (lookup_index >= lookup_count)) return nullptr;
+
+    retry:
+      hb_ot_layout_lookup_accelerator_t *accel = accels[lookup_index].get_acquire ();
+      if (unlikely (!accel))
+      {
+	accel = hb_ot_layout_lookup_accelerator_t::create (table->get_lookup (lookup_index), &accel_budget);
+	if (unlikely (!accel))
+	  return nullptr;
+
+	if (unlikely (!accels[lookup_index].cmpexch (nullptr, accel)))
+	{
+	  accel->fini (&accel_budget);
+	  hb_free (accel);
+	  goto retry;
+	}
+      }
+
+      return accel;
+    }
+
     hb_blob_ptr_t<T> table;
     unsigned int lookup_count;
-    hb_ot_layout_lookup_accelerator_t *accels;
+    hb_atomic_ptr_t<hb_ot_layout_lookup_accelerator_t> *accels;
+    /* Bytes left for coverage bitmaps and subtable caches of the lookup
+     * accelerators. */
+    mutable hb_atomic_int_t accel_budget;
+#ifndef HB_NO_VAR
+    FeatureVariations::accelerator_t feature_variations;
+#endif
   };
 
   protected:
@@ -255,7 +255,7 @@ _hb_ot_layout_set_glyph_props (hb_font_t *font,
 {
   _hb_buffer_assert_gsubgpos_vars (buffer);
 
-  const OT::GDEF &gdef = *font->face->table.GDEF->table;
+  const OT::GDEF_accelerator_t &gdef = *font->face->table.GDEF;
   unsigned int count = buffer->len;
   for (unsigned int i = 0; i < count; i++)
   {
@@ -1324,6 +1324,32 @@ hb_ot_layout_lookup_collect_glyphs (hb_face_t    *face,
 }
 #endif
 
+bool
+hb_ot_layout_lookup_collect_touched_glyphs (hb_face_t    *face,
+					    hb_tag_t      table_tag,
+					    unsigned int  lookup_index,
+					    hb_set_t     *glyphs)
+{
+#ifdef HB_NO_LAYOUT_COLLECT_GLYPHS
+  return false;
+#else
+  const OT::GSUBGPOS &g = get_gsubgpos_table (face, table_tag);
+  if (g.get_lookup (lookup_index).get_props () & OT::LookupFlag::IgnoreBaseGlyphs)
+    return false;
+
+  hb_ot_layout_lookup_collect_glyphs (face, table_tag, lookup_index,
+				      glyphs, glyphs, glyphs, glyphs);
+  return !glyphs->in_error ();
+#endif
+}
+
+bool
+hb_ot_layout_lookup_is_single_substitution (hb_face_t    *face,
+					    unsigned int  lookup_index)
+{
+  return face->table.GSUB->table->get_lookup (lookup_index).is_single ();
+}
+
 
 /* Variations support */
 
@@ -1351,9 +1377,23 @@ hb_ot_layout_table_find_feature_variations (hb_face_t    *face,
 					    unsigned int  num_coords,
 					    unsigned int *variations_index /* out */)
 {
-  const OT::GSUBGPOS &g = get_gsubgpos_table (face, table_tag);
+  switch (table_tag) {
+    case HB_OT_TAG_GSUB: return face->table.GSUB->find_variations_index (coords, num_coords, variations_index);
+    case HB_OT_TAG_GPOS: return face->table.GPOS->find_variations_index (coords, num_coords, variations_index);
+    default:             return Null (OT::GSUBGPOS).find_variations_index (coords, num_coords, variations_index);
+  }
+}
 
-  return g.find_variations_index (coords, num_coords, variations_index);
+bool
+hb_ot_layout_table_collect_feature_variations (hb_face_t    *face,
+					       hb_tag_t      table_tag,
+					       hb_set_t     *variations_indices)
+{
+  switch (table_tag) {
+    case HB_OT_TAG_GSUB: return face->table.GSUB->collect_variations_indices (variations_indices);
+    case HB_OT_TAG_GPOS: return face->table.GPOS->collect_variations_indices (variations_indices);
+    default:             return true;
+  }
 }
 
 
@@ -1445,7 +1485,8 @@ hb_ot_layout_lookup_would_substitute (hb_face_t            *face,
   OT::hb_would_apply_context_t c (face, glyphs, glyphs_length, (bool) zero_context);
 
   const OT::SubstLookup& l = face->table.GSUB->table->get_lookup (lookup_index);
-  return l.would_apply (&c, &face->table.GSUB->accels[lookup_index]);
+  auto *accel = face->table.GSUB->get_accel (lookup_index);
+  return accel && l.would_apply (&c, accel);
 }
 
 
@@ -1834,11 +1875,11 @@ struct GSUBProxy
   typedef OT::SubstLookup Lookup;
 
   GSUBProxy (hb_face_t *face) :
-    table (*face->table.GSUB->table),
-    accels (face->table.GSUB->accels) {}
+    accel (*face->table.GSUB),
+    table (*accel.table) {}
 
+  const GSUB::accelerator_t &accel;
   const GSUB &table;
-  const OT::hb_ot_layout_lookup_accelerator_t *accels;
 };
 
 struct GPOSProxy
@@ -1848,21 +1889,22 @@ struct GPOSProxy
   typedef OT::PosLookup Lookup;
 
   GPOSProxy (hb_face_t *face) :
-    table (*face->table.GPOS->table),
-    accels (face->table.GPOS->accels) {}
+    accel (*face->table.GPOS),
+    table (*accel.table) {}
 
+  const GPOS::accelerator_t &accel;
   const GPOS &table;
-  const OT::hb_ot_layout_lookup_accelerator_t *accels;
 };
 
 
 static inline bool
 apply_forward (OT::hb_ot_apply_context_t *c,
-	       const OT::hb_ot_layout_lookup_accelerator_t &accel)
+	       const OT::hb_ot_layout_lookup_accelerator_t &accel,
+	       hb_ot_map_t::profile_t::lookup_stats_t *stats)
 {
   bool use_cache = accel.cache_enter (c);
 
-  bool ret = false;
+  unsigned int visited = 0, applications = 0;
   hb_buffer_t *buffer = c->buffer;
   while (buffer->idx < buffer->len && buffer->successful)
   {
@@ -1871,11 +1913,12 @@ apply_forward (OT::hb_ot_apply_context_t *c,
 	(buffer->cur().mask & c->lookup_mask) &&
 	c->check_glyph_property (&buffer->cur(), c->lookup_props))
      {
+       visited++;
        applied = accel.apply (c, use_cache);
      }
 
     if (applied)
-      ret = true;
+      applications++;
     else
       (void) buffer->next_glyph ();
   }
@@ -1883,41 +1926,63 @@ apply_forward (OT::hb_ot_apply_context_t *c,
   if (use_cache)
     accel.cache_leave (c);
 
-  return ret;
+  if (stats)
+  {
+    stats->glyphs_visited += visited;
+    stats->applications += applications;
+  }
+
+  return applications;
 }
 
 static inline bool
 apply_backward (OT::hb_ot_apply_context_t *c,
-	       const OT::hb_ot_layout_lookup_accelerator_t &accel)
+	       const OT::hb_ot_layout_lookup_accelerator_t &accel,
+	       hb_ot_map_t::profile_t::lookup_stats_t *stats)
 {
-  bool ret = false;
+  unsigned int visited = 0, applications = 0;
   hb_buffer_t *buffer = c->buffer;
   do
   {
     if (accel.may_have (buffer->cur().codepoint) &&
 	(buffer->cur().mask & c->lookup_mask) &&
 	c->check_glyph_property (&buffer->cur(), c->lookup_props))
-     ret |= accel.apply (c, false);
+    {
+      visited++;
+      applications += accel.apply (c, false);
+    }
 
     /* The reverse lookup doesn't "advance" cursor (for good reason). */
     buffer->idx--;
 
   }
   while ((int) buffer->idx >= 0);
-  return ret;
+
+  if (stats)
+  {
+    stats->glyphs_visited += visited;
+    stats->applications += applications;
+  }
+
+  return applications;
 }
 
 template <typename Proxy>
 static inline void
 apply_string (OT::hb_ot_apply_context_t *c,
 	      const typename Proxy::Lookup &lookup,
-	      const OT::hb_ot_layout_lookup_accelerator_t &accel)
+	      const OT::hb_ot_layout_lookup_accelerator_t &accel,
+	      hb_ot_map_t::profile_t::lookup_stats_t *stats = nullptr)
 {
   hb_buffer_t *buffer = c->buffer;
 
   if (unlikely (!buffer->len || !c->lookup_mask))
     return;
 
+  /* Skip the whole lookup if no glyph in the buffer can match it. */
+  if (!accel.may_have (c->digest) || !(c->masks & c->lookup_mask))
+    return;
+
   c->set_lookup_props (lookup.get_props ());
 
   if (likely (!lookup.is_reverse ()))
@@ -1927,7 +1992,7 @@ apply_string (OT::hb_ot_apply_context_t *c,
       buffer->clear_output ();
 
     buffer->idx = 0;
-    apply_forward (c, accel);
+    apply_forward (c, accel, stats);
 
     if (!Proxy::always_inplace)
       buffer->sync ();
@@ -1937,9 +2002,80 @@ apply_string (OT::hb_ot_apply_context_t *c,
     /* in-place backward substitution/positioning */
     assert (!buffer->have_output);
     buffer->idx = buffer->len - 1;
-    apply_backward (c, accel);
+    apply_backward (c, accel, stats);
+  }
+}
+
+#ifndef HB_NO_OT_LAYOUT_FUSE_SINGLE_SUBSTS
+/* Applies a run of consecutive lookups that are all made of SingleSubst
+ * subtables in one pass over the buffer, passing each glyph through the
+ * lookups in order.  Such lookups only look at the glyph they substitute,
+ * so this is what applying them one after another would do.  Returns the
+ * number of lookups applied, or zero to have the caller apply the first
+ * lookup on its own. */
+template <typename Proxy>
+static inline unsigned
+apply_single_substs (const Proxy &proxy,
+		     OT::hb_ot_apply_context_t *c,
+		     const hb_ot_map_t::lookup_map_t *lookups,
+		     unsigned int count)
+{
+  struct
+  {
+    const OT::hb_ot_layout_lookup_accelerator_t *accel;
+    const hb_map_t *mapping;
+    hb_mask_t mask;
+    unsigned lookup_props;
+  } run[32];
+
+  hb_buffer_t *buffer = c->buffer;
+  /* Messages are sent for each lookup. */
+  if (buffer->messaging ())
+    return 0;
+
+  count = hb_min (count, ARRAY_LENGTH (run));
+  unsigned int n = 0;
+  for (; n < count && lookups[n].single_subst; n++)
+  {
+    const auto &lookup = proxy.table.get_lookup (lookups[n].index);
+    auto *accel = proxy.accel.get_accel (lookups[n].index);
+    const hb_map_t *mapping = accel ? accel->get_single_substs (lookup, &proxy.accel.accel_budget) : nullptr;
+    if (unlikely (!mapping))
+      break;
+    run[n].accel = accel;
+    run[n].mapping = mapping;
+    run[n].mask = lookups[n].mask;
+    run[n].lookup_props = lookup.get_props ();
+  }
+  if (n < 2)
+    return 0;
+
+  if (unlikely (!buffer->len))
+    return n;
+
+  buffer->clear_output ();
+  buffer->idx = 0;
+  while (buffer->idx < buffer->len && buffer->successful)
+  {
+    hb_glyph_info_t *info = &buffer->cur();
+    for (unsigned int i = 0; i < n; i++)
+    {
+      if (!((info->mask & run[i].mask) &&
+	    run[i].accel->may_have (info->codepoint) &&
+	    c->check_glyph_property (info, run[i].lookup_props)))
+	continue;
+
+      hb_codepoint_t substitute = run[i].mapping->get (info->codepoint);
+      if (substitute != HB_MAP_VALUE_INVALID)
+	c->replace_glyph_inplace (substitute);
+    }
+    (void) buffer->next_glyph ();
   }
+  buffer->sync ();
+
+  return n;
 }
+#endif
 
 template <typename Proxy>
 inline void hb_ot_map_t::apply (const Proxy &proxy,
@@ -1952,11 +2088,40 @@ inline void hb_ot_map_t::apply (const Proxy &proxy,
   OT::hb_ot_apply_context_t c (table_index, font, buffer);
   c.set_recurse_func (Proxy::Lookup::template dispatch_recurse_func<OT::hb_ot_apply_context_t>);
 
+  /* Counted here and added to the profile at the end, as other threads
+   * may be applying the same plan. */
+  profile_t *profile = plan->get_profile ();
+  hb_vector_t<profile_t::lookup_stats_t> lookup_stats;
+  hb_vector_t<profile_t::stage_stats_t> stage_stats;
+  if (unlikely (profile) &&
+      unlikely (!lookup_stats.resize (lookups[table_index].length) ||
+		!stage_stats.resize (stages[table_index].length)))
+    profile = nullptr;
+
   for (unsigned int stage_index = 0; stage_index < stages[table_index].length; stage_index++)
   {
     const stage_map_t *stage = &stages[table_index][stage_index];
+    uint64_t stage_start = unlikely (profile) ? profile_t::now_ns () : 0;
     for (; i < stage->last_lookup; i++)
     {
+#ifndef HB_NO_OT_LAYOUT_FUSE_SINGLE_SUBSTS
+      /* Only runs of two or more are worth their maps. */
+      if (!Proxy::always_inplace && !profile &&
+	  lookups[table_index][i].single_subst &&
+	  i + 1 < stage->last_lookup &&
+	  lookups[table_index][i + 1].single_subst)
+      {
+	unsigned int applied = apply_single_substs (proxy, &c,
+						    &lookups[table_index][i],
+						    stage->last_lookup - i);
+	if (applied)
+	{
+	  i += applied - 1;
+	  continue;
+	}
+      }
+#endif
+
       unsigned int lookup_index = lookups[table_index][i].index;
       if (!buffer->message (font, "start lookup %d", lookup_index)) continue;
       c.set_lookup_index (lookup_index);
@@ -1966,15 +2131,48 @@ inline void hb_ot_map_t::apply (const Proxy &proxy,
       c.set_random (lookups[table_index][i].random);
       c.set_per_syllable (lookups[table_index][i].per_syllable);
 
-      apply_string<Proxy> (&c,
-			   proxy.table.get_lookup (lookup_index),
-			   proxy.accels[lookup_index]);
+      auto *accel = proxy.accel.get_accel (lookup_index);
+      if (unlikely (profile))
+      {
+	profile_t::lookup_stats_t &stats = lookup_stats[i];
+	uint64_t start = profile_t::now_ns ();
+	if (likely (accel))
+	  apply_string<Proxy> (&c,
+			       proxy.table.get_lookup (lookup_index),
+			       *accel,
+			       &stats);
+	stats.invocations++;
+	stats.time_ns += profile_t::now_ns () - start;
+      }
+      else if (likely (accel))
+	apply_string<Proxy> (&c,
+			     proxy.table.get_lookup (lookup_index),
+			     *accel);
       (void) buffer->message (font, "end lookup %d", lookup_index);
     }
 
     if (stage->pause_func)
+    {
+      uint64_t pause_start = unlikely (profile) ? profile_t::now_ns () : 0;
       stage->pause_func (plan, font, buffer);
+      if (unlikely (profile))
+	stage_stats[stage_index].pause_time_ns += profile_t::now_ns () - pause_start;
+      /* Pause functions may have changed the glyphs and their masks;
+       * refresh both. */
+      c.digest = buffer->digest ();
+      c.masks = buffer->mask_union ();
+    }
+
+    if (unlikely (profile))
+    {
+      profile_t::stage_stats_t &stats = stage_stats[stage_index];
+      stats.invocations++;
+      stats.time_ns += profile_t::now_ns () - stage_start;
+    }
   }
+
+  if (unlikely (profile))
+    profile->merge (table_index, lookup_stats, stage_stats);
 }
 
 void hb_ot_map_t::substitute (const hb_ot_shape_plan_t *plan, hb_font_t *font, hb_buffer_t *buffer) const
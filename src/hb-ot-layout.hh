@@ -106,6 +106,28 @@ HB_INTERNAL void
 hb_ot_layout_delete_glyphs_inplace (hb_buffer_t *buffer,
 				    bool (*filter) (const hb_glyph_info_t *info));
 
+/* Adds every glyph the lookup can match, produce, or use as context to
+ * @glyphs.  Returns false if that set cannot be bounded, e.g. because the
+ * lookup skips over base glyphs. */
+HB_INTERNAL bool
+hb_ot_layout_lookup_collect_touched_glyphs (hb_face_t    *face,
+					    hb_tag_t      table_tag,
+					    unsigned int  lookup_index,
+					    hb_set_t     *glyphs);
+
+/* Adds the index of each FeatureVariations record that
+ * hb_ot_layout_table_find_feature_variations() finds at some coordinates
+ * to @variations_indices.  Returns whether it finds none at some. */
+HB_INTERNAL bool
+hb_ot_layout_table_collect_feature_variations (hb_face_t    *face,
+					       hb_tag_t      table_tag,
+					       hb_set_t     *variations_indices);
+
+/* Whether the GSUB lookup is made of SingleSubst subtables only. */
+HB_INTERNAL bool
+hb_ot_layout_lookup_is_single_substitution (hb_face_t    *face,
+					    unsigned int  lookup_index);
+
 namespace OT {
   struct hb_ot_apply_context_t;
   struct hb_ot_layout_lookup_accelerator_t;
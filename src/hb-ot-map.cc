@@ -42,6 +42,56 @@ void hb_ot_map_t::collect_lookups (unsigned int table_index, hb_set_t *lookups_o
 }
 
 
+bool hb_ot_map_t::profile_t::init (const hb_ot_map_t &map)
+{
+  lock.init ();
+  enabled.set_relaxed (false);
+  for (unsigned int table_index = 0; table_index < 2; table_index++)
+  {
+    lookups[table_index].init ();
+    stages[table_index].init ();
+    if (unlikely (!lookups[table_index].resize (map.lookups[table_index].length) ||
+		  !stages[table_index].resize (map.stages[table_index].length)))
+      return false;
+  }
+  return true;
+}
+
+void hb_ot_map_t::profile_t::reset ()
+{
+  hb_lock_t l (lock);
+  for (unsigned int table_index = 0; table_index < 2; table_index++)
+  {
+    for (unsigned int i = 0; i < lookups[table_index].length; i++)
+      lookups[table_index][i] = lookup_stats_t ();
+    for (unsigned int i = 0; i < stages[table_index].length; i++)
+      stages[table_index][i] = stage_stats_t ();
+  }
+}
+
+void hb_ot_map_t::profile_t::merge (unsigned int table_index,
+				    hb_array_t<const lookup_stats_t> lookup_stats,
+				    hb_array_t<const stage_stats_t> stage_stats)
+{
+  hb_lock_t l (lock);
+  for (unsigned int i = 0; i < lookup_stats.length; i++)
+  {
+    lookup_stats_t &stats = lookups[table_index][i];
+    stats.invocations += lookup_stats[i].invocations;
+    stats.glyphs_visited += lookup_stats[i].glyphs_visited;
+    stats.applications += lookup_stats[i].applications;
+    stats.time_ns += lookup_stats[i].time_ns;
+  }
+  for (unsigned int i = 0; i < stage_stats.length; i++)
+  {
+    stage_stats_t &stats = stages[table_index][i];
+    stats.invocations += stage_stats[i].invocations;
+    stats.time_ns += stage_stats[i].time_ns;
+    stats.pause_time_ns += stage_stats[i].pause_time_ns;
+  }
+}
+
+
 hb_ot_map_builder_t::hb_ot_map_builder_t (hb_face_t *face_,
 					  const hb_segment_properties_t &props_)
 {
@@ -162,6 +212,10 @@ hb_ot_map_builder_t::add_lookups (hb_ot_map_t  &m,
       lookup->auto_zwj = auto_zwj;
       lookup->random = random;
       lookup->per_syllable = per_syllable;
+#ifndef HB_NO_OT_LAYOUT_FUSE_SINGLE_SUBSTS
+      lookup->single_subst = table_index == 0 &&
+			     hb_ot_layout_lookup_is_single_substitution (face, lookup->index);
+#endif
     }
 
     offset += len;
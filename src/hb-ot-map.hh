@@ -31,6 +31,8 @@
 
 #include "hb-buffer.hh"
 
+#include <time.h>
+
 
 #define HB_OT_MAP_MAX_BITS 8u
 #define HB_OT_MAP_MAX_VALUE ((1u << HB_OT_MAP_MAX_BITS) - 1u)
@@ -68,6 +70,7 @@ struct hb_ot_map_t
     unsigned short auto_zwj : 1;
     unsigned short random : 1;
     unsigned short per_syllable : 1;
+    unsigned short single_subst : 1; /* SingleSubst subtables only. */
     hb_mask_t mask;
 
     HB_INTERNAL static int cmp (const void *pa, const void *pb)
@@ -85,6 +88,55 @@ struct hb_ot_map_t
     pause_func_t pause_func;
   };
 
+  /* Statistics collected by apply() while profiling is enabled on a plan.
+   * Entries run parallel to lookups[] and stages[].  Each apply() call
+   * counts on its own and adds its counts in under the lock once done. */
+  struct profile_t
+  {
+    struct lookup_stats_t {
+      unsigned int invocations;
+      unsigned int glyphs_visited;
+      unsigned int applications;
+      uint64_t time_ns;
+    };
+    struct stage_stats_t {
+      unsigned int invocations;
+      uint64_t time_ns;
+      uint64_t pause_time_ns;
+    };
+
+    HB_INTERNAL bool init (const hb_ot_map_t &map);
+    void fini ()
+    {
+      for (unsigned int table_index = 0; table_index < 2; table_index++)
+      {
+	lookups[table_index].fini ();
+	stages[table_index].fini ();
+      }
+      lock.fini ();
+    }
+    HB_INTERNAL void reset ();
+    HB_INTERNAL void merge (unsigned int table_index,
+			    hb_array_t<const lookup_stats_t> lookup_stats,
+			    hb_array_t<const stage_stats_t> stage_stats);
+
+    static uint64_t now_ns ()
+    {
+#ifdef CLOCK_MONOTONIC
+      struct timespec ts;
+      clock_gettime (CLOCK_MONOTONIC, &ts);
+      return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+#else
+      return (uint64_t) clock () * (1000000000u / CLOCKS_PER_SEC);
+#endif
+    }
+
+    hb_atomic_int_t enabled;
+    mutable hb_mutex_t lock;
+    hb_vector_t<lookup_stats_t> lookups[2]; /* GSUB/GPOS */
+    hb_vector_t<stage_stats_t> stages[2]; /* GSUB/GPOS */
+  };
+
   void init ()
   {
     memset (this, 0, sizeof (*this));
@@ -151,6 +203,18 @@ struct hb_ot_map_t
   }
 
   HB_INTERNAL void collect_lookups (unsigned int table_index, hb_set_t *lookups) const;
+  unsigned int get_lookup_index (unsigned int table_index, unsigned int i) const
+  { return lookups[table_index][i].index; }
+  unsigned int get_stage_end (unsigned int table_index, unsigned int stage) const
+  { return stages[table_index][stage].last_lookup; }
+
+  bool has_random_lookups () const
+  {
+    for (unsigned int i = 0; i < lookups[0].length; i++)
+      if (lookups[0][i].random)
+	return true;
+    return false;
+  }
   template <typename Proxy>
   HB_INTERNAL void apply (const Proxy &proxy,
 			  const struct hb_ot_shape_plan_t *plan, hb_font_t *font, hb_buffer_t *buffer) const;
@@ -40,6 +40,7 @@
 #include "hb-ot-shaper.hh"
 #include "hb-ot-shape-fallback.hh"
 #include "hb-ot-shape-normalize.hh"
+#include "hb-ot-shaper-arabic.hh"
 
 #include "hb-ot-face.hh"
 
@@ -213,6 +214,16 @@ hb_ot_shape_planner_t::compile (hb_ot_shape_plan_t           &plan,
   /* Currently we always apply trak. */
   plan.apply_trak = plan.requested_tracking && hb_aat_layout_has_tracking (face);
 #endif
+
+#ifndef HB_NO_OT_SHAPE_SIMPLE
+  /* Left-to-right text on the default shaper needs no preprocessing,
+   * direction changes, or mirroring; if it also needs no normalization,
+   * hb_ot_shape_internal() can go straight to mapping glyphs. */
+  plan.apply_simple = plan.shaper == &_hb_ot_shaper_default &&
+		      !plan.apply_morx &&
+		      props.direction == HB_DIRECTION_LTR &&
+		      hb_script_get_horizontal_direction (props.script) != HB_DIRECTION_RTL;
+#endif
 }
 
 bool
@@ -259,6 +270,17 @@ hb_ot_shape_plan_t::fini ()
 #ifndef HB_NO_AAT_SHAPE
   aat_map.fini ();
 #endif
+
+  hb_set_destroy (touched_glyphs.get_relaxed ());
+  touched_glyphs.set_relaxed (nullptr);
+
+  hb_ot_map_t::profile_t *p = profile.get_relaxed ();
+  if (p)
+  {
+    p->fini ();
+    hb_free (p);
+  }
+  profile.set_relaxed (nullptr);
 }
 
 void
@@ -297,6 +319,65 @@ hb_ot_shape_plan_t::position (hb_font_t   *font,
 #endif
 }
 
+static void
+hb_ot_shape_collect_touched_glyphs (const hb_ot_shape_plan_t *plan,
+				    hb_face_t                *face,
+				    hb_set_t                 *glyphs)
+{
+  /* We cannot tell which glyphs these see. */
+  if (plan->apply_morx || plan->apply_kerx || plan->apply_kern || plan->apply_trak ||
+      do_fallback_arabic (plan))
+  {
+    glyphs->invert ();
+    return;
+  }
+
+  for (unsigned table_index = 0; table_index < 2; table_index++)
+  {
+    if (table_index == 1 && !plan->apply_gpos)
+      continue;
+
+    hb_tag_t table_tag = table_index ? HB_OT_TAG_GPOS : HB_OT_TAG_GSUB;
+    hb_set_t lookups;
+    plan->map.collect_lookups (table_index, &lookups);
+    for (unsigned lookup_index : lookups)
+      if (!hb_ot_layout_lookup_collect_touched_glyphs (face, table_tag, lookup_index, glyphs))
+      {
+	glyphs->clear ();
+	glyphs->invert ();
+	return;
+      }
+  }
+}
+
+bool
+hb_ot_shape_plan_t::glyph_is_untouched (hb_face_t      *face,
+					hb_codepoint_t  glyph) const
+{
+  /* Lookups skip over marks and ligatures without seeing them. */
+  hb_ot_layout_glyph_class_t klass = hb_ot_layout_get_glyph_class (face, glyph);
+  if (klass != HB_OT_LAYOUT_GLYPH_CLASS_UNCLASSIFIED &&
+      klass != HB_OT_LAYOUT_GLYPH_CLASS_BASE_GLYPH)
+    return false;
+
+retry:
+  hb_set_t *glyphs = touched_glyphs.get_acquire ();
+  if (unlikely (!glyphs))
+  {
+    glyphs = hb_set_create ();
+    if (unlikely (glyphs == hb_set_get_empty ()))
+      return false;
+    hb_ot_shape_collect_touched_glyphs (this, face, glyphs);
+    if (unlikely (!touched_glyphs.cmpexch (nullptr, glyphs)))
+    {
+      hb_set_destroy (glyphs);
+      goto retry;
+    }
+  }
+
+  return !glyphs->in_error () && !glyphs->has (glyph);
+}
+
 
 static const hb_ot_map_feature_t
 common_features[] =
@@ -778,6 +859,15 @@ hb_ot_shape_setup_masks_fraction (const hb_ot_shape_context_t *c)
 	end++;
 
       buffer->unsafe_to_break (start, end);
+      /* The numerator may go on before the text, which is at the end of
+       * the buffer if it was reversed to the native direction. */
+      if (buffer->props.direction == c->target_direction)
+      {
+	if (!start)
+	  buffer->unsafe_to_concat_from_outbuffer (0, i + 1);
+      }
+      else if (end == count)
+	buffer->unsafe_to_concat_from_outbuffer (i, count);
 
       for (unsigned int j = start; j < i; j++)
 	info[j].mask |= pre_mask;
@@ -954,17 +1044,65 @@ hb_ot_substitute_pre (const hb_ot_shape_context_t *c)
 #endif
 }
 
+/* Maps the characters to their nominal glyphs if the buffer needs no
+ * normalization, that is, it has no marks or other grapheme continuations
+ * and the font has glyphs for all characters.  On success, leaves the
+ * glyphs in glyph_index(), allocated. */
+static inline bool
+hb_ot_substitute_simple_start (const hb_ot_shape_context_t *c)
+{
+  hb_buffer_t *buffer = c->buffer;
+  unsigned int count = buffer->len;
+  hb_glyph_info_t *info = buffer->info;
+
+  /* Continuations are all outside ASCII. */
+  if (buffer->scratch_flags & HB_BUFFER_SCRATCH_FLAG_HAS_NON_ASCII)
+    for (unsigned int i = 0; i < count; i++)
+      if (_hb_glyph_info_is_continuation (&info[i]))
+	return false;
+
+  HB_BUFFER_ALLOCATE_VAR (buffer, glyph_index);
+  if (c->font->get_nominal_glyphs (count,
+				   &info[0].codepoint, sizeof (info[0]),
+				   &info[0].glyph_index (), sizeof (info[0])) == count)
+    return true;
+  HB_BUFFER_DEALLOCATE_VAR (buffer, glyph_index);
+  return false;
+}
+
+/* hb_ot_substitute_pre() for buffers hb_ot_substitute_simple_start()
+ * accepted.  Grapheme clusters are single characters, there is no mark
+ * to put a dotted circle before, and normalization would only map the
+ * glyphs; and the plan rules out direction changes and shaper hooks. */
+static inline void
+hb_ot_substitute_simple (const hb_ot_shape_context_t *c)
+{
+  hb_buffer_t *buffer = c->buffer;
+
+  hb_ot_shape_setup_masks (c);
+
+  hb_ot_map_glyphs_fast (buffer);
+
+  HB_BUFFER_DEALLOCATE_VAR (buffer, glyph_index);
+
+  _hb_buffer_allocate_gsubgpos_vars (buffer);
+
+  hb_ot_substitute_plan (c);
+}
+
+template <bool simple>
 static inline void
 hb_ot_substitute_post (const hb_ot_shape_context_t *c)
 {
 #ifndef HB_NO_AAT_SHAPE
-  if (c->plan->apply_morx && !c->plan->apply_gpos)
+  if (!simple && c->plan->apply_morx && !c->plan->apply_gpos)
     hb_aat_layout_remove_deleted_glyphs (c->buffer);
 #endif
 
   hb_ot_hide_default_ignorables (c->buffer, c->font);
 
-  if (c->plan->shaper->postprocess_glyphs &&
+  if (!simple &&
+      c->plan->shaper->postprocess_glyphs &&
     c->buffer->message(c->font, "start postprocess-glyphs")) {
     c->plan->shaper->postprocess_glyphs (c->plan, c->buffer, c->font);
     (void) c->buffer->message(c->font, "end postprocess-glyphs");
@@ -1179,6 +1317,10 @@ hb_propagate_flags (hb_buffer_t *buffer)
 
 /* Pull it all together! */
 
+/* The simple instance is used for plans with apply_simple set.  It takes
+ * a shortcut through substitution for buffers that need no normalization,
+ * and drops the steps the plan rules out. */
+template <bool simple>
 static void
 hb_ot_shape_internal (hb_ot_shape_context_t *c)
 {
@@ -1189,22 +1331,28 @@ hb_ot_shape_internal (hb_ot_shape_context_t *c)
 
   hb_ot_shape_initialize_masks (c);
   hb_set_unicode_props (c->buffer);
-  hb_insert_dotted_circle (c->buffer, c->font);
 
-  hb_form_clusters (c->buffer);
+  if (simple && hb_ot_substitute_simple_start (c))
+    hb_ot_substitute_simple (c);
+  else
+  {
+    hb_insert_dotted_circle (c->buffer, c->font);
 
-  hb_ensure_native_direction (c->buffer);
+    hb_form_clusters (c->buffer);
 
-  if (c->plan->shaper->preprocess_text &&
-      c->buffer->message(c->font, "start preprocess-text"))
-  {
-    c->plan->shaper->preprocess_text (c->plan, c->buffer, c->font);
-    (void) c->buffer->message(c->font, "end preprocess-text");
-  }
+    hb_ensure_native_direction (c->buffer);
+
+    if (c->plan->shaper->preprocess_text &&
+	c->buffer->message(c->font, "start preprocess-text"))
+    {
+      c->plan->shaper->preprocess_text (c->plan, c->buffer, c->font);
+      (void) c->buffer->message(c->font, "end preprocess-text");
+    }
 
-  hb_ot_substitute_pre (c);
+    hb_ot_substitute_pre (c);
+  }
   hb_ot_position (c);
-  hb_ot_substitute_post (c);
+  hb_ot_substitute_post<simple> (c);
 
   hb_propagate_flags (c->buffer);
 
@@ -1224,7 +1372,10 @@ _hb_ot_shape (hb_shape_plan_t    *shape_plan,
 	      unsigned int        num_features)
 {
   hb_ot_shape_context_t c = {&shape_plan->ot, font, font->face, buffer, features, num_features};
-  hb_ot_shape_internal (&c);
+  if (shape_plan->ot.apply_simple)
+    hb_ot_shape_internal<true> (&c);
+  else
+    hb_ot_shape_internal<false> (&c);
 
   return true;
 }
@@ -1249,6 +1400,222 @@ hb_ot_shape_plan_collect_lookups (hb_shape_plan_t *shape_plan,
   shape_plan->ot.collect_lookups (table_tag, lookup_indexes);
 }
 
+/**
+ * hb_ot_shape_plan_set_profiling:
+ * @shape_plan: #hb_shape_plan_t to profile
+ * @enabled: Whether to collect statistics
+ *
+ * Enables or disables collection of per-lookup and per-stage statistics
+ * whenever @shape_plan is executed.  Statistics collected so far are kept
+ * when profiling is disabled; use hb_ot_shape_plan_reset_profile() to
+ * clear them.
+ *
+ * Profiling adds two clock reads per lookup, so it should not be left on
+ * in production.  Each execution adds its statistics once it is done,
+ * so @shape_plan can be shared between threads while profiling.
+ *
+ * Return value: `true` if profiling could be set up, `false` otherwise.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_ot_shape_plan_set_profiling (hb_shape_plan_t *shape_plan,
+				hb_bool_t        enabled)
+{
+  if (unlikely (shape_plan->header.is_inert ()))
+    return false;
+
+  const hb_ot_shape_plan_t &plan = shape_plan->ot;
+
+retry:
+  hb_ot_map_t::profile_t *profile = plan.profile.get_acquire ();
+  if (!profile)
+  {
+    if (!enabled)
+      return true;
+
+    profile = (hb_ot_map_t::profile_t *) hb_calloc (1, sizeof (hb_ot_map_t::profile_t));
+    if (unlikely (!profile))
+      return false;
+    if (unlikely (!profile->init (plan.map)))
+    {
+      profile->fini ();
+      hb_free (profile);
+      return false;
+    }
+
+    if (unlikely (!plan.profile.cmpexch (nullptr, profile)))
+    {
+      profile->fini ();
+      hb_free (profile);
+      goto retry;
+    }
+  }
+
+  profile->enabled.set_release (enabled);
+  return true;
+}
+
+/**
+ * hb_ot_shape_plan_get_profiling:
+ * @shape_plan: #hb_shape_plan_t to query
+ *
+ * Fetches whether statistics are being collected for @shape_plan.
+ *
+ * Return value: `true` if profiling is enabled, `false` otherwise.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_ot_shape_plan_get_profiling (hb_shape_plan_t *shape_plan)
+{
+  return shape_plan->ot.get_profile () != nullptr;
+}
+
+/**
+ * hb_ot_shape_plan_reset_profile:
+ * @shape_plan: #hb_shape_plan_t to reset
+ *
+ * Clears the statistics collected for @shape_plan.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_ot_shape_plan_reset_profile (hb_shape_plan_t *shape_plan)
+{
+  hb_ot_map_t::profile_t *profile = shape_plan->ot.profile.get_acquire ();
+  if (profile)
+    profile->reset ();
+}
+
+/**
+ * hb_ot_shape_plan_get_lookup_profiles:
+ * @shape_plan: #hb_shape_plan_t to query
+ * @start_offset: offset of the first profile to retrieve
+ * @profile_count: (inout) (optional): Input = the maximum number of profiles
+ *   to return; Output = the actual number of profiles returned
+ * @profiles: (out) (array length=profile_count) (optional): The statistics
+ *   of the lookups
+ *
+ * Fetches the statistics collected for the lookups of @shape_plan, GSUB
+ * lookups first, each table in the order the lookups are applied.  A
+ * lookup shared by several stages is reported once per stage.
+ *
+ * Return value: Total number of lookups in @shape_plan, or zero if
+ * profiling was never enabled.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_ot_shape_plan_get_lookup_profiles (hb_shape_plan_t                   *shape_plan,
+				      unsigned int                       start_offset,
+				      unsigned int                      *profile_count /* IN/OUT.  May be NULL. */,
+				      hb_ot_shape_plan_lookup_profile_t *profiles      /* OUT.     May be NULL. */)
+{
+  const hb_ot_shape_plan_t &plan = shape_plan->ot;
+  const hb_ot_map_t::profile_t *profile = plan.profile.get_acquire ();
+  if (!profile)
+  {
+    if (profile_count)
+      *profile_count = 0;
+    return 0;
+  }
+
+  unsigned int total = profile->lookups[0].length + profile->lookups[1].length;
+  if (profile_count)
+  {
+    hb_lock_t l (profile->lock);
+    hb_array_t<hb_ot_shape_plan_lookup_profile_t> out (profiles, *profile_count);
+    unsigned int count = 0;
+    unsigned int n = 0;
+    for (unsigned int table_index = 0; table_index < 2; table_index++)
+    {
+      unsigned int stage_index = 0;
+      for (unsigned int i = 0; i < profile->lookups[table_index].length; i++, n++)
+      {
+	while (stage_index + 1 < profile->stages[table_index].length &&
+	       i >= plan.map.get_stage_end (table_index, stage_index))
+	  stage_index++;
+
+	if (n < start_offset || count >= out.length)
+	  continue;
+
+	const hb_ot_map_t::profile_t::lookup_stats_t &stats = profile->lookups[table_index][i];
+	hb_ot_shape_plan_lookup_profile_t &p = out[count++];
+	p.table_tag = table_tags[table_index];
+	p.lookup_index = plan.map.get_lookup_index (table_index, i);
+	p.stage_index = stage_index;
+	p.invocations = stats.invocations;
+	p.glyphs_visited = stats.glyphs_visited;
+	p.applications = stats.applications;
+	p.time_ns = stats.time_ns;
+      }
+    }
+    *profile_count = count;
+  }
+
+  return total;
+}
+
+/**
+ * hb_ot_shape_plan_get_stage_profiles:
+ * @shape_plan: #hb_shape_plan_t to query
+ * @start_offset: offset of the first profile to retrieve
+ * @profile_count: (inout) (optional): Input = the maximum number of profiles
+ *   to return; Output = the actual number of profiles returned
+ * @profiles: (out) (array length=profile_count) (optional): The statistics
+ *   of the stages
+ *
+ * Fetches the statistics collected for the stages of @shape_plan, GSUB
+ * stages first.  Stages are separated by shaper callbacks, whose time is
+ * reported separately.
+ *
+ * Return value: Total number of stages in @shape_plan, or zero if
+ * profiling was never enabled.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_ot_shape_plan_get_stage_profiles (hb_shape_plan_t                  *shape_plan,
+				     unsigned int                      start_offset,
+				     unsigned int                     *profile_count /* IN/OUT.  May be NULL. */,
+				     hb_ot_shape_plan_stage_profile_t *profiles      /* OUT.     May be NULL. */)
+{
+  const hb_ot_map_t::profile_t *profile = shape_plan->ot.profile.get_acquire ();
+  if (!profile)
+  {
+    if (profile_count)
+      *profile_count = 0;
+    return 0;
+  }
+
+  unsigned int total = profile->stages[0].length + profile->stages[1].length;
+  if (profile_count)
+  {
+    hb_lock_t l (profile->lock);
+    hb_array_t<hb_ot_shape_plan_stage_profile_t> out (profiles, *profile_count);
+    unsigned int count = 0;
+    unsigned int n = 0;
+    for (unsigned int table_index = 0; table_index < 2; table_index++)
+      for (unsigned int i = 0; i < profile->stages[table_index].length; i++, n++)
+      {
+	if (n < start_offset || count >= out.length)
+	  continue;
+
+	const hb_ot_map_t::profile_t::stage_stats_t &stats = profile->stages[table_index][i];
+	hb_ot_shape_plan_stage_profile_t &p = out[count++];
+	p.table_tag = table_tags[table_index];
+	p.stage_index = i;
+	p.invocations = stats.invocations;
+	p.time_ns = stats.time_ns;
+	p.pause_time_ns = stats.pause_time_ns;
+      }
+    *profile_count = count;
+  }
+
+  return total;
+}
+
 
 /* TODO Move this to hb-ot-shape-normalize, make it do decompose, and make it public. */
 static void
@@ -48,6 +48,73 @@ hb_ot_shape_plan_collect_lookups (hb_shape_plan_t *shape_plan,
 				  hb_tag_t         table_tag,
 				  hb_set_t        *lookup_indexes /* OUT */);
 
+/**
+ * hb_ot_shape_plan_lookup_profile_t:
+ * @table_tag: %HB_OT_TAG_GSUB or %HB_OT_TAG_GPOS.
+ * @lookup_index: Index of the lookup in the table.
+ * @stage_index: Index of the stage the lookup runs in.
+ * @invocations: Number of times the lookup was run over a buffer.
+ * @glyphs_visited: Number of glyphs the lookup's subtables were tried on.
+ * @applications: Number of times the lookup applied.
+ * @time_ns: Time spent running the lookup, in nanoseconds.
+ *
+ * Statistics collected for one lookup of a shape plan while profiling.
+ *
+ * Since: REPLACEME
+ **/
+typedef struct hb_ot_shape_plan_lookup_profile_t {
+  hb_tag_t     table_tag;
+  unsigned int lookup_index;
+  unsigned int stage_index;
+  unsigned int invocations;
+  unsigned int glyphs_visited;
+  unsigned int applications;
+  uint64_t     time_ns;
+} hb_ot_shape_plan_lookup_profile_t;
+
+/**
+ * hb_ot_shape_plan_stage_profile_t:
+ * @table_tag: %HB_OT_TAG_GSUB or %HB_OT_TAG_GPOS.
+ * @stage_index: Index of the stage in the table.
+ * @invocations: Number of times the stage was run.
+ * @time_ns: Time spent in the stage, including its pause, in nanoseconds.
+ * @pause_time_ns: Time spent in the shaper callback that ends the
+ *   stage, in nanoseconds.
+ *
+ * Statistics collected for one stage of a shape plan while profiling.
+ *
+ * Since: REPLACEME
+ **/
+typedef struct hb_ot_shape_plan_stage_profile_t {
+  hb_tag_t     table_tag;
+  unsigned int stage_index;
+  unsigned int invocations;
+  uint64_t     time_ns;
+  uint64_t     pause_time_ns;
+} hb_ot_shape_plan_stage_profile_t;
+
+HB_EXTERN hb_bool_t
+hb_ot_shape_plan_set_profiling (hb_shape_plan_t *shape_plan,
+				hb_bool_t        enabled);
+
+HB_EXTERN hb_bool_t
+hb_ot_shape_plan_get_profiling (hb_shape_plan_t *shape_plan);
+
+HB_EXTERN void
+hb_ot_shape_plan_reset_profile (hb_shape_plan_t *shape_plan);
+
+HB_EXTERN unsigned int
+hb_ot_shape_plan_get_lookup_profiles (hb_shape_plan_t                   *shape_plan,
+				      unsigned int                       start_offset,
+				      unsigned int                      *profile_count /* IN/OUT.  May be NULL. */,
+				      hb_ot_shape_plan_lookup_profile_t *profiles      /* OUT.     May be NULL. */);
+
+HB_EXTERN unsigned int
+hb_ot_shape_plan_get_stage_profiles (hb_shape_plan_t                  *shape_plan,
+				     unsigned int                      start_offset,
+				     unsigned int                     *profile_count /* IN/OUT.  May be NULL. */,
+				     hb_ot_shape_plan_stage_profile_t *profiles      /* OUT.     May be NULL. */);
+
 HB_END_DECLS
 
 #endif /* HB_OT_SHAPE_H */
@@ -48,6 +48,11 @@ struct hb_ot_shape_plan_key_t
 						  num_coords,
 						  &variations_index[table_index]);
   }
+  void init (const unsigned int *variations_index_)
+  {
+    for (unsigned int table_index = 0; table_index < 2; table_index++)
+      variations_index[table_index] = variations_index_[table_index];
+  }
 
   bool equal (const hb_ot_shape_plan_key_t *other)
   {
@@ -124,6 +129,23 @@ struct hb_ot_shape_plan_t
   static constexpr bool apply_morx = false;
   static constexpr bool apply_trak = false;
 #endif
+#ifndef HB_NO_OT_SHAPE_SIMPLE
+  bool apply_simple : 1;
+#else
+  static constexpr bool apply_simple = false;
+#endif
+
+  /* Glyphs any lookup of the plan may see; built on first use. */
+  mutable hb_atomic_ptr_t<hb_set_t> touched_glyphs;
+
+  /* Lookup statistics; allocated when profiling is first enabled. */
+  mutable hb_atomic_ptr_t<hb_ot_map_t::profile_t> profile;
+
+  hb_ot_map_t::profile_t *get_profile () const
+  {
+    hb_ot_map_t::profile_t *p = profile.get_acquire ();
+    return unlikely (p && p->enabled) ? p : nullptr;
+  }
 
   void collect_lookups (hb_tag_t table_tag, hb_set_t *lookups) const
   {
@@ -142,6 +164,10 @@ struct hb_ot_shape_plan_t
 
   HB_INTERNAL void substitute (hb_font_t *font, hb_buffer_t *buffer) const;
   HB_INTERNAL void position (hb_font_t *font, hb_buffer_t *buffer) const;
+
+  /* Whether nothing in the plan can match, skip over, or kern @glyph.
+   * Text can then be shaped independently on either side of it. */
+  HB_INTERNAL bool glyph_is_untouched (hb_face_t *face, hb_codepoint_t glyph) const;
 };
 
 struct hb_shape_plan_t;
@@ -287,6 +287,16 @@ data_create_arabic (const hb_ot_shape_plan_t *plan)
   return arabic_plan;
 }
 
+bool
+do_fallback_arabic (const hb_ot_shape_plan_t *plan)
+{
+  if (plan->shaper != &_hb_ot_shaper_arabic)
+    return false;
+
+  const arabic_shape_plan_t *arabic_plan = (const arabic_shape_plan_t *) plan->data;
+  return arabic_plan->do_fallback;
+}
+
 void
 data_destroy_arabic (void *data)
 {
@@ -42,6 +42,11 @@ data_create_arabic (const hb_ot_shape_plan_t *plan);
 HB_INTERNAL void
 data_destroy_arabic (void *data);
 
+/* Whether @plan, of the Arabic shaper, synthesizes lookups from the
+ * Unicode presentation forms. */
+HB_INTERNAL bool
+do_fallback_arabic (const hb_ot_shape_plan_t *plan);
+
 HB_INTERNAL void
 setup_masks_arabic_plan (const arabic_shape_plan_t *arabic_plan,
 			 hb_buffer_t               *buffer,
@@ -0,0 +1,720 @@
+/*
+ * Copyright © 2026  The HarfBuzz Authors
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include "hb.hh"
+#include "hb-shape-cache.hh"
+
+#include "hb-font.hh"
+#include "hb-shape-plan.hh"
+#include "hb-shaper.hh"
+
+
+/**
+ * SECTION:hb-shape-cache
+ * @title: hb-shape-cache
+ * @short_description: Caching of shaping results
+ * @include: hb.h
+ *
+ * Most text is made of a small set of words repeated over and over.  Shape
+ * caches remember what those words shaped to, such that shaping them again
+ * is a lookup instead of running the shaper.
+ *
+ * hb_shape_cache_shape() splits the text into words at spaces that the
+ * font's lookups never see, shapes the words it has not seen before on
+ * their own, and pieces the results together.  Where the font does not
+ * allow that, it falls back to shaping the text as a whole.  Either way,
+ * the result is the same as hb_shape_full() would produce.
+ **/
+
+
+/*
+ * hb_shape_cache_t::key_t
+ */
+
+uint32_t
+hb_shape_cache_t::key_t::hash () const
+{
+  uint32_t h = hb_hash ((const void *) shape_plan);
+  h = h * 31 + hb_hash ((unsigned) flags);
+  h = h * 31 + hb_hash ((unsigned) cluster_level);
+  h = h * 31 + hb_hash (replacement);
+  h = h * 31 + hb_hash (invisible);
+  h = h * 31 + hb_hash (not_found);
+  for (unsigned int i = 0; i < 2; i++)
+  {
+    h = h * 31 + hb_hash (context_len[i]);
+    for (unsigned int j = 0; j < context_len[i]; j++)
+      h = h * 31 + hb_hash (context[i][j]);
+  }
+  h = h * 31 + hb_hash (length);
+  for (unsigned int i = 0; i < length; i++)
+    h = h * 31 + hb_hash (text[i]);
+  return h;
+}
+
+bool
+hb_shape_cache_t::key_t::equal (const key_t &other) const
+{
+  if (shape_plan != other.shape_plan ||
+      flags != other.flags ||
+      cluster_level != other.cluster_level ||
+      replacement != other.replacement ||
+      invisible != other.invisible ||
+      not_found != other.not_found ||
+      length != other.length)
+    return false;
+  for (unsigned int i = 0; i < 2; i++)
+    if (context_len[i] != other.context_len[i] ||
+	0 != hb_memcmp (context[i], other.context[i], context_len[i] * sizeof (context[i][0])))
+      return false;
+  return 0 == hb_memcmp (text, other.text, length * sizeof (text[0]));
+}
+
+
+/*
+ * hb_shape_cache_t
+ */
+
+bool
+hb_shape_cache_t::init (unsigned int max_entries_)
+{
+  font = nullptr;
+  font_serial = 0;
+  unicode = nullptr;
+
+  buckets.init ();
+  most_recent = least_recent = nullptr;
+  population = 0;
+  max_entries = max_entries_;
+
+  hits = misses = 0;
+
+  text.init ();
+  clusters.init ();
+  words.init ();
+  scratch = hb_buffer_create ();
+  return hb_object_is_valid (scratch);
+}
+
+void
+hb_shape_cache_t::fini ()
+{
+  clear ();
+  buckets.fini ();
+
+  text.fini ();
+  clusters.fini ();
+  words.fini ();
+  hb_buffer_destroy (scratch);
+  scratch = nullptr;
+
+  hb_font_destroy (font);
+  font = nullptr;
+  hb_unicode_funcs_destroy (unicode);
+  unicode = nullptr;
+}
+
+void
+hb_shape_cache_t::clear ()
+{
+  for (entry_t *entry = most_recent; entry; )
+  {
+    entry_t *next = entry->next_used;
+    hb_shape_plan_destroy (entry->key.shape_plan);
+    hb_free (entry);
+    entry = next;
+  }
+  most_recent = least_recent = nullptr;
+  population = 0;
+  buckets.resize (0);
+}
+
+void
+hb_shape_cache_t::reset_font (hb_font_t          *font_,
+			      hb_unicode_funcs_t *unicode_)
+{
+  clear ();
+
+  hb_font_destroy (font);
+  font = hb_font_reference (font_);
+  font_serial = font_->serial;
+
+  hb_unicode_funcs_destroy (unicode);
+  unicode = hb_unicode_funcs_reference (unicode_);
+  hb_buffer_set_unicode_funcs (scratch, unicode);
+}
+
+void
+hb_shape_cache_t::link (entry_t *entry)
+{
+  entry->prev_used = nullptr;
+  entry->next_used = most_recent;
+  if (most_recent) most_recent->prev_used = entry;
+  most_recent = entry;
+  if (!least_recent) least_recent = entry;
+}
+
+void
+hb_shape_cache_t::unlink (entry_t *entry)
+{
+  if (entry->prev_used) entry->prev_used->next_used = entry->next_used;
+  else most_recent = entry->next_used;
+  if (entry->next_used) entry->next_used->prev_used = entry->prev_used;
+  else least_recent = entry->prev_used;
+  entry->prev_used = entry->next_used = nullptr;
+}
+
+void
+hb_shape_cache_t::use (entry_t *entry)
+{
+  if (entry == most_recent)
+    return;
+  unlink (entry);
+  link (entry);
+}
+
+void
+hb_shape_cache_t::evict ()
+{
+  entry_t *entry = least_recent;
+  if (unlikely (!entry))
+    return;
+
+  unlink (entry);
+  for (entry_t **p = &buckets.arrayZ[entry->hash & (buckets.length - 1)]; *p; p = &(*p)->next)
+    if (*p == entry)
+    {
+      *p = entry->next;
+      break;
+    }
+
+  hb_shape_plan_destroy (entry->key.shape_plan);
+  hb_free (entry);
+  population--;
+}
+
+bool
+hb_shape_cache_t::resize ()
+{
+  if (likely (population < buckets.length))
+    return true;
+
+  unsigned int new_length = hb_max (64u, buckets.length * 2);
+  hb_vector_t<entry_t *> new_buckets;
+  if (unlikely (!new_buckets.resize (new_length)))
+    return buckets.length; /* Keep going with longer chains. */
+
+  for (entry_t *entry = most_recent; entry; entry = entry->next_used)
+  {
+    entry_t **bucket = &new_buckets.arrayZ[entry->hash & (new_length - 1)];
+    entry->next = *bucket;
+    *bucket = entry;
+  }
+  buckets = std::move (new_buckets);
+  return true;
+}
+
+hb_shape_cache_t::entry_t *
+hb_shape_cache_t::lookup (const key_t &key, uint32_t hash) const
+{
+  if (unlikely (!buckets.length))
+    return nullptr;
+
+  for (entry_t *entry = buckets.arrayZ[hash & (buckets.length - 1)]; entry; entry = entry->next)
+    if (entry->hash == hash && entry->key.equal (key))
+      return entry;
+  return nullptr;
+}
+
+/* Shapes the word of @key on its own, and remembers the result. */
+hb_shape_cache_t::entry_t *
+hb_shape_cache_t::insert (const key_t        &key,
+			  uint32_t            hash,
+			  hb_font_t          *font,
+			  const hb_feature_t *features,
+			  unsigned int        num_features)
+{
+  hb_buffer_t *buffer = scratch;
+  buffer->clear ();
+  buffer->props = key.shape_plan->key.props;
+  buffer->flags = key.flags;
+  buffer->cluster_level = key.cluster_level;
+  buffer->replacement = key.replacement;
+  buffer->invisible = key.invisible;
+  buffer->not_found = key.not_found;
+  buffer->content_type = HB_BUFFER_CONTENT_TYPE_UNICODE;
+  for (unsigned int i = 0; i < key.length; i++)
+    buffer->add (key.text[i], i);
+  for (unsigned int i = 0; i < 2; i++)
+  {
+    buffer->context_len[i] = key.context_len[i];
+    hb_memcpy (buffer->context[i], key.context[i], key.context_len[i] * sizeof (key.context[i][0]));
+  }
+  if (unlikely (!buffer->successful))
+    return nullptr;
+
+  buffer->enter ();
+  bool res = hb_shape_plan_execute (key.shape_plan, font, buffer, features, num_features);
+  if (buffer->max_ops <= 0)
+    buffer->shaping_failed = true;
+  buffer->leave ();
+  if (unlikely (!res || !buffer->successful || buffer->shaping_failed))
+    return nullptr;
+
+  if (unlikely (!resize ()))
+    return nullptr;
+
+  unsigned int num_glyphs = buffer->len;
+  entry_t *entry = (entry_t *) hb_malloc (sizeof (entry_t) +
+					  num_glyphs * sizeof (hb_glyph_info_t) +
+					  num_glyphs * sizeof (hb_glyph_position_t) +
+					  key.length * sizeof (hb_codepoint_t));
+  if (unlikely (!entry))
+    return nullptr;
+
+  entry->info = (hb_glyph_info_t *) (entry + 1);
+  entry->pos = (hb_glyph_position_t *) (entry->info + num_glyphs);
+  hb_codepoint_t *text = (hb_codepoint_t *) (entry->pos + num_glyphs);
+  entry->num_glyphs = num_glyphs;
+  hb_memcpy (entry->info, buffer->info, num_glyphs * sizeof (buffer->info[0]));
+  hb_memcpy (entry->pos, buffer->pos, num_glyphs * sizeof (buffer->pos[0]));
+  hb_memcpy (text, key.text, key.length * sizeof (key.text[0]));
+
+  entry->key = key;
+  entry->key.text = text;
+  hb_shape_plan_reference (key.shape_plan);
+  entry->hash = hash;
+
+  entry_t **bucket = &buckets.arrayZ[hash & (buckets.length - 1)];
+  entry->next = *bucket;
+  *bucket = entry;
+  link (entry);
+  population++;
+
+  return entry;
+}
+
+/* Splits the text into words.  Returns false if some word is too long
+ * to be cached. */
+bool
+hb_shape_cache_t::split (hb_shape_plan_t *shape_plan,
+			 hb_font_t       *font,
+			 hb_buffer_t     *buffer)
+{
+  bool split_at_spaces = shape_plan->can_split_at_spaces (font, buffer);
+
+  words.resize (0);
+  unsigned int count = text.length;
+  unsigned int start = 0;
+  for (unsigned int i = 1; i <= count; i++)
+  {
+    if (i < count &&
+	!(split_at_spaces &&
+	  _hb_shape_can_split_before (buffer->unicode, text.arrayZ[i - 1], text.arrayZ[i])))
+      continue;
+
+    if (i - start > HB_SHAPE_CACHE_MAX_WORD_LENGTH)
+      return false;
+    words.push (word_t {start, i, nullptr});
+    start = i;
+  }
+  return !words.in_error ();
+}
+
+void
+hb_shape_cache_t::fill_key (key_t             *key,
+			    hb_shape_plan_t   *shape_plan,
+			    const hb_buffer_t *buffer,
+			    unsigned int       start,
+			    unsigned int       end) const
+{
+  key->shape_plan = shape_plan;
+
+  /* Only the first and last words are at the beginning / end of text. */
+  unsigned int flags = buffer->flags & ~(HB_BUFFER_FLAG_BOT |
+					 HB_BUFFER_FLAG_EOT);
+  if (start == 0)
+    flags |= buffer->flags & HB_BUFFER_FLAG_BOT;
+  if (end == text.length)
+    flags |= buffer->flags & HB_BUFFER_FLAG_EOT;
+  key->flags = (hb_buffer_flags_t) flags;
+
+  key->cluster_level = buffer->cluster_level;
+  key->replacement = buffer->replacement;
+  key->invisible = buffer->invisible;
+  key->not_found = buffer->not_found;
+
+  /* The shapers only look at context up to the first character that is not
+   * a continuation; trimming the rest makes more words share entries. */
+  auto add_context = [&] (unsigned int i, hb_codepoint_t u)
+  {
+    key->context[i][key->context_len[i]++] = u;
+    return key->context_len[i] < hb_buffer_t::CONTEXT_LENGTH &&
+	   _hb_shape_is_continuation (buffer->unicode, u);
+  };
+  key->context_len[0] = key->context_len[1] = 0;
+  bool more = true;
+  for (unsigned int i = start; more && i; )
+    more = add_context (0, text.arrayZ[--i]);
+  for (unsigned int i = 0; more && i < buffer->context_len[0]; i++)
+    more = add_context (0, buffer->context[0][i]);
+  more = true;
+  for (unsigned int i = end; more && i < text.length; i++)
+    more = add_context (1, text.arrayZ[i]);
+  for (unsigned int i = 0; more && i < buffer->context_len[1]; i++)
+    more = add_context (1, buffer->context[1][i]);
+
+  key->length = end - start;
+  key->text = text.arrayZ + start;
+}
+
+/* Replaces the contents of @buffer with the glyphs of the words. */
+void
+hb_shape_cache_t::assemble (hb_buffer_t  *buffer,
+			    unsigned int  num_glyphs)
+{
+  if (unlikely (!buffer->ensure (num_glyphs)))
+    return;
+
+  buffer->len = num_glyphs;
+  buffer->clear_positions ();
+  buffer->content_type = HB_BUFFER_CONTENT_TYPE_GLYPHS;
+
+  bool backward = HB_DIRECTION_IS_BACKWARD (buffer->props.direction);
+  hb_glyph_info_t *info = buffer->info;
+  hb_glyph_position_t *pos = buffer->pos;
+  unsigned int j = 0;
+  for (unsigned int k = 0; k < words.length; k++)
+  {
+    const word_t &word = words.arrayZ[backward ? words.length - 1 - k : k];
+    const entry_t *entry = word.entry;
+    for (unsigned int i = 0; i < entry->num_glyphs; i++, j++)
+    {
+      info[j] = entry->info[i];
+      info[j].cluster = clusters.arrayZ[word.start + entry->info[i].cluster];
+      pos[j] = entry->pos[i];
+    }
+  }
+}
+
+bool
+hb_shape_cache_t::shape (hb_font_t          *font_,
+			 hb_buffer_t        *buffer,
+			 const hb_feature_t *features,
+			 unsigned int        num_features,
+			 const char * const *shaper_list)
+{
+  if (unlikely (!buffer->len))
+    return true;
+
+  if (buffer->content_type != HB_BUFFER_CONTENT_TYPE_UNICODE ||
+      buffer->messaging () ||
+      (buffer->flags & HB_BUFFER_FLAG_VERIFY))
+    return hb_shape_full (font_, buffer, features, num_features, shaper_list);
+
+  /* Words are shaped with clusters starting at zero, so features that apply
+   * to a cluster range would select the wrong glyphs. */
+  for (unsigned int i = 0; i < num_features; i++)
+    if (features[i].start != HB_FEATURE_GLOBAL_START ||
+	features[i].end != HB_FEATURE_GLOBAL_END)
+      return hb_shape_full (font_, buffer, features, num_features, shaper_list);
+
+  /* Word results carry clusters relative to the word start, which only maps
+   * back if clusters are increasing. */
+  unsigned int count = buffer->len;
+  if (unlikely (!text.resize (count) || !clusters.resize (count)))
+    return hb_shape_full (font_, buffer, features, num_features, shaper_list);
+  const hb_glyph_info_t *info = buffer->info;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    if (i && info[i].cluster <= info[i - 1].cluster)
+      return hb_shape_full (font_, buffer, features, num_features, shaper_list);
+    text.arrayZ[i] = info[i].codepoint;
+    clusters.arrayZ[i] = info[i].cluster;
+  }
+
+  if (font_ != font || font_->serial != font_serial || buffer->unicode != unicode)
+    reset_font (font_, buffer->unicode);
+
+  hb_shape_plan_t *shape_plan = hb_shape_plan_create_cached2 (font->face, &buffer->props,
+							      features, num_features,
+							      font->coords, font->num_coords,
+							      shaper_list);
+
+  bool fallback = !split (shape_plan, font, buffer);
+
+  for (unsigned int i = 0; !fallback && i < words.length; i++)
+  {
+    word_t &word = words.arrayZ[i];
+    key_t key;
+    fill_key (&key, shape_plan, buffer, word.start, word.end);
+    uint32_t hash = key.hash ();
+
+    word.entry = lookup (key, hash);
+    if (word.entry)
+    {
+      hits++;
+      use (word.entry);
+    }
+    else
+    {
+      misses++;
+      word.entry = insert (key, hash, font, features, num_features);
+      fallback = !word.entry;
+    }
+  }
+
+  unsigned int num_glyphs = 0;
+  for (unsigned int i = 0; !fallback && i < words.length; i++)
+    num_glyphs += words.arrayZ[i].entry->num_glyphs;
+
+  bool ret;
+  if (fallback)
+    ret = hb_shape_full (font, buffer, features, num_features, shaper_list);
+  else
+  {
+    assemble (buffer, num_glyphs);
+    ret = buffer->successful;
+  }
+
+  hb_shape_plan_destroy (shape_plan);
+
+  /* Only evict now, as the words above point into the cache. */
+  while (max_entries && population > max_entries)
+    evict ();
+
+  return ret;
+}
+
+
+/*
+ * hb_shape_cache_t public API
+ */
+
+/**
+ * hb_shape_cache_create:
+ * @max_entries: The maximum number of words to keep, or zero for no limit
+ *
+ * Creates a new, empty, shape cache.  Once it holds @max_entries words,
+ * the least recently used ones are evicted to make room for new ones.
+ *
+ * Return value: (transfer full): The new shape cache
+ *
+ * Since: REPLACEME
+ **/
+hb_shape_cache_t *
+hb_shape_cache_create (unsigned int max_entries)
+{
+  hb_shape_cache_t *cache;
+
+  if (!(cache = hb_object_create<hb_shape_cache_t> ()))
+    return hb_shape_cache_get_empty ();
+
+  if (unlikely (!cache->init (max_entries)))
+  {
+    hb_shape_cache_destroy (cache);
+    return hb_shape_cache_get_empty ();
+  }
+
+  return cache;
+}
+
+/**
+ * hb_shape_cache_get_empty:
+ *
+ * Fetches the singleton empty shape cache.  Shaping with it is the same
+ * as shaping with hb_shape_full().
+ *
+ * Return value: (transfer full): The empty shape cache
+ *
+ * Since: REPLACEME
+ **/
+hb_shape_cache_t *
+hb_shape_cache_get_empty ()
+{
+  return const_cast<hb_shape_cache_t *> (&Null (hb_shape_cache_t));
+}
+
+/**
+ * hb_shape_cache_reference: (skip)
+ * @cache: A shape cache
+ *
+ * Increases the reference count on the given shape cache.
+ *
+ * Return value: (transfer full): @cache
+ *
+ * Since: REPLACEME
+ **/
+hb_shape_cache_t *
+hb_shape_cache_reference (hb_shape_cache_t *cache)
+{
+  return hb_object_reference (cache);
+}
+
+/**
+ * hb_shape_cache_destroy: (skip)
+ * @cache: A shape cache
+ *
+ * Decreases the reference count on the given shape cache. When the
+ * reference count reaches zero, the shape cache is destroyed,
+ * freeing all memory.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_shape_cache_destroy (hb_shape_cache_t *cache)
+{
+  if (!hb_object_destroy (cache)) return;
+
+  hb_free (cache);
+}
+
+/**
+ * hb_shape_cache_set_user_data: (skip)
+ * @cache: A shape cache
+ * @key: The user-data key to set
+ * @data: A pointer to the user data
+ * @destroy: (nullable): A callback to call when @data is not needed anymore
+ * @replace: Whether to replace an existing data with the same key
+ *
+ * Attaches a user-data key/data pair to the given shape cache.
+ *
+ * Return value: `true` if success, `false` otherwise.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_shape_cache_set_user_data (hb_shape_cache_t   *cache,
+			      hb_user_data_key_t *key,
+			      void *              data,
+			      hb_destroy_func_t   destroy,
+			      hb_bool_t           replace)
+{
+  return hb_object_set_user_data (cache, key, data, destroy, replace);
+}
+
+/**
+ * hb_shape_cache_get_user_data: (skip)
+ * @cache: A shape cache
+ * @key: The user-data key to query
+ *
+ * Fetches the user data associated with the specified key,
+ * attached to the specified shape cache.
+ *
+ * Return value: (transfer none): A pointer to the user data
+ *
+ * Since: REPLACEME
+ **/
+void *
+hb_shape_cache_get_user_data (const hb_shape_cache_t *cache,
+			      hb_user_data_key_t     *key)
+{
+  return hb_object_get_user_data (cache, key);
+}
+
+/**
+ * hb_shape_cache_clear:
+ * @cache: A shape cache
+ *
+ * Removes all words from @cache.  The hit and miss counters are kept.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_shape_cache_clear (hb_shape_cache_t *cache)
+{
+  if (unlikely (!hb_object_is_valid (cache)))
+    return;
+
+  cache->clear ();
+}
+
+/**
+ * hb_shape_cache_get_stats:
+ * @cache: A shape cache
+ * @hits: (out) (optional): Number of words found in the cache
+ * @misses: (out) (optional): Number of words that had to be shaped
+ *
+ * Fetches the counters of @cache, accumulated since it was created.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_shape_cache_get_stats (const hb_shape_cache_t *cache,
+			  unsigned int           *hits,   /* OUT.  May be NULL. */
+			  unsigned int           *misses  /* OUT.  May be NULL. */)
+{
+  if (hits) *hits = cache->hits;
+  if (misses) *misses = cache->misses;
+}
+
+/**
+ * hb_shape_cache_shape:
+ * @cache: A shape cache
+ * @font: an #hb_font_t to use for shaping
+ * @buffer: an #hb_buffer_t to shape
+ * @features: (array length=num_features) (nullable): an array of user
+ *    specified #hb_feature_t or `NULL`
+ * @num_features: the length of @features array
+ * @shaper_list: (array zero-terminated=1) (nullable): a `NULL`-terminated
+ *    array of shapers to use or `NULL`
+ *
+ * Shapes @buffer like hb_shape_full() does, reusing the results of earlier
+ * calls with @cache where possible.
+ *
+ * The text is split into words at U+0020 SPACE characters, if no lookup
+ * of the font involves the space glyph, and @buffer does not ask for
+ * #HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT.  Otherwise the whole text is
+ * one word.  Each word is looked up in @cache by its text and surrounding
+ * context, the shape plan, and the flags and settings of @buffer; words
+ * not found are shaped on their own and added.
+ *
+ * If the clusters of @buffer are not increasing, a message function is
+ * set, @buffer has #HB_BUFFER_FLAG_VERIFY set, a feature in @features
+ * applies to part of the text only, or a word is very long, @buffer is
+ * shaped with hb_shape_full() instead.
+ *
+ * A cache holds results for one font at a time.  Calling this function
+ * with a different font, or after @font was modified, empties @cache.
+ * The cache keeps a reference to the last font used with it.
+ *
+ * A shape cache must not be used from multiple threads at the same time.
+ *
+ * Return value: false if all shapers failed, true otherwise
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_shape_cache_shape (hb_shape_cache_t   *cache,
+		      hb_font_t          *font,
+		      hb_buffer_t        *buffer,
+		      const hb_feature_t *features,
+		      unsigned int        num_features,
+		      const char * const *shaper_list)
+{
+  if (unlikely (!hb_object_is_valid (cache)))
+    return hb_shape_full (font, buffer, features, num_features, shaper_list);
+
+  return cache->shape (font, buffer, features, num_features, shaper_list);
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright © 2026  The HarfBuzz Authors
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef HB_SHAPE_CACHE_HH
+#define HB_SHAPE_CACHE_HH
+
+#include "hb.hh"
+#include "hb-buffer.hh"
+
+
+/* Words longer than this are shaped, but not cached. */
+#ifndef HB_SHAPE_CACHE_MAX_WORD_LENGTH
+#define HB_SHAPE_CACHE_MAX_WORD_LENGTH 64
+#endif
+
+struct hb_shape_cache_t
+{
+  ~hb_shape_cache_t () { fini (); }
+
+  /* Everything, besides the font, that shaping a word depends on. */
+  struct key_t
+  {
+    hb_shape_plan_t *shape_plan;
+    hb_buffer_flags_t flags;
+    hb_buffer_cluster_level_t cluster_level;
+    hb_codepoint_t replacement;
+    hb_codepoint_t invisible;
+    hb_codepoint_t not_found;
+    unsigned int context_len[2];
+    hb_codepoint_t context[2][hb_buffer_t::CONTEXT_LENGTH];
+    unsigned int length;
+    const hb_codepoint_t *text;
+
+    HB_INTERNAL uint32_t hash () const;
+    HB_INTERNAL bool equal (const key_t &other) const;
+  };
+
+  struct entry_t
+  {
+    entry_t *next;	/* Next in hash bucket. */
+    entry_t *prev_used;	/* More recently used. */
+    entry_t *next_used;	/* Less recently used. */
+    uint32_t hash;
+    key_t key;		/* Owns a reference to key.shape_plan. */
+
+    /* In visual order, with clusters relative to the start of the word. */
+    unsigned int num_glyphs;
+    hb_glyph_info_t *info;
+    hb_glyph_position_t *pos;
+  };
+
+  struct word_t
+  {
+    unsigned int start;
+    unsigned int end;
+    entry_t *entry;
+  };
+
+  hb_object_header_t header;
+
+  /* Entries are only valid for this font state.  The font and unicode funcs
+   * are referenced, such that their pointers cannot be reused. */
+  hb_font_t *font;
+  unsigned int font_serial;
+  hb_unicode_funcs_t *unicode;
+
+  hb_vector_t<entry_t *> buckets;
+  entry_t *most_recent;
+  entry_t *least_recent;
+  unsigned int population;
+  unsigned int max_entries;
+
+  unsigned int hits;
+  unsigned int misses;
+
+  /* Scratch space reused across calls. */
+  hb_buffer_t *scratch;
+  hb_vector_t<hb_codepoint_t> text;
+  hb_vector_t<unsigned int> clusters;
+  hb_vector_t<word_t> words;
+
+  HB_INTERNAL bool init (unsigned int max_entries);
+  HB_INTERNAL void fini ();
+  HB_INTERNAL void clear ();
+
+  HB_INTERNAL bool shape (hb_font_t          *font,
+			  hb_buffer_t        *buffer,
+			  const hb_feature_t *features,
+			  unsigned int        num_features,
+			  const char * const *shaper_list);
+
+  private:
+  void reset_font (hb_font_t *font, hb_unicode_funcs_t *unicode);
+  bool split (hb_shape_plan_t *shape_plan, hb_font_t *font, hb_buffer_t *buffer);
+  void fill_key (key_t *key, hb_shape_plan_t *shape_plan, const hb_buffer_t *buffer,
+		 unsigned int start, unsigned int end) const;
+  entry_t *lookup (const key_t &key, uint32_t hash) const;
+  entry_t *insert (const key_t &key, uint32_t hash, hb_font_t *font,
+		   const hb_feature_t *features, unsigned int num_features);
+  void assemble (hb_buffer_t *buffer, unsigned int num_glyphs);
+  void link (entry_t *entry);
+  void unlink (entry_t *entry);
+  void use (entry_t *entry);
+  void evict ();
+  bool resize ();
+};
+
+
+#endif /* HB_SHAPE_CACHE_HH */
@@ -29,6 +29,7 @@
 #include "hb-shaper.hh"
 #include "hb-font.hh"
 #include "hb-buffer.hh"
+#include "hb-ot-layout.hh"
 
 
 /**
@@ -63,6 +64,7 @@ hb_shape_plan_key_t::init (bool                           copy,
 			   unsigned int                   num_user_features,
 			   const int                     *coords,
 			   unsigned int                   num_coords,
+			   const unsigned int            *variations_index,
 			   const char * const            *shaper_list)
 {
   hb_feature_t *features = nullptr;
@@ -87,7 +89,10 @@ hb_shape_plan_key_t::init (bool                           copy,
   this->shaper_func = nullptr;
   this->shaper_name = nullptr;
 #ifndef HB_NO_OT_SHAPE
-  this->ot.init (face, coords, num_coords);
+  if (variations_index)
+    this->ot.init (variations_index);
+  else
+    this->ot.init (face, coords, num_coords);
 #endif
 
   /*
@@ -163,6 +168,29 @@ hb_shape_plan_key_t::equal (const hb_shape_plan_key_t *other)
 	 this->shaper_func == other->shaper_func;
 }
 
+uint32_t
+hb_shape_plan_key_t::hash () const
+{
+  /* Must agree with equal(). */
+  uint32_t h = hb_hash (props.direction);
+  h = h * 31 + hb_hash (props.script);
+  h = h * 31 + hb_hash ((const void *) props.language);
+  h = h * 31 + hb_hash (num_user_features);
+  for (unsigned int i = 0; i < num_user_features; i++)
+  {
+    h = h * 31 + hb_hash (user_features[i].tag);
+    h = h * 31 + hb_hash (user_features[i].value);
+    h = h * 31 + (user_features[i].start == HB_FEATURE_GLOBAL_START &&
+		  user_features[i].end   == HB_FEATURE_GLOBAL_END);
+  }
+#ifndef HB_NO_OT_SHAPE
+  h = h * 31 + hb_hash (ot.variations_index[0]);
+  h = h * 31 + hb_hash (ot.variations_index[1]);
+#endif
+  h = h * 31 + hb_hash ((const void *) shaper_func);
+  return h;
+}
+
 
 /*
  * hb_shape_plan_t
@@ -197,31 +225,14 @@ hb_shape_plan_create (hb_face_t                     *face,
 				shaper_list);
 }
 
-/**
- * hb_shape_plan_create2:
- * @face: #hb_face_t to use
- * @props: The #hb_segment_properties_t of the segment
- * @user_features: (array length=num_user_features): The list of user-selected features
- * @num_user_features: The number of user-selected features
- * @coords: (array length=num_coords): The list of variation-space coordinates
- * @num_coords: The number of variation-space coordinates
- * @shaper_list: (array zero-terminated=1): List of shapers to try
- *
- * The variable-font version of #hb_shape_plan_create. 
- * Constructs a shaping plan for a combination of @face, @user_features, @props,
- * and @shaper_list, plus the variation-space coordinates @coords.
- *
- * Return value: (transfer full): The shaping plan
- *
- * Since: 1.4.0
- **/
-hb_shape_plan_t *
-hb_shape_plan_create2 (hb_face_t                     *face,
+static hb_shape_plan_t *
+_hb_shape_plan_create (hb_face_t                     *face,
 		       const hb_segment_properties_t *props,
 		       const hb_feature_t            *user_features,
 		       unsigned int                   num_user_features,
 		       const int                     *coords,
 		       unsigned int                   num_coords,
+		       const unsigned int            *variations_index,
 		       const char * const            *shaper_list)
 {
   DEBUG_MSG_FUNC (SHAPE_PLAN, nullptr,
@@ -253,6 +264,7 @@ hb_shape_plan_create2 (hb_face_t                     *face,
 				       num_user_features,
 				       coords,
 				       num_coords,
+				       variations_index,
 				       shaper_list)))
     goto bail2;
 #ifndef HB_NO_OT_SHAPE
@@ -272,6 +284,40 @@ bail:
   return hb_shape_plan_get_empty ();
 }
 
+/**
+ * hb_shape_plan_create2:
+ * @face: #hb_face_t to use
+ * @props: The #hb_segment_properties_t of the segment
+ * @user_features: (array length=num_user_features): The list of user-selected features
+ * @num_user_features: The number of user-selected features
+ * @coords: (array length=num_coords): The list of variation-space coordinates
+ * @num_coords: The number of variation-space coordinates
+ * @shaper_list: (array zero-terminated=1): List of shapers to try
+ *
+ * The variable-font version of #hb_shape_plan_create. 
+ * Constructs a shaping plan for a combination of @face, @user_features, @props,
+ * and @shaper_list, plus the variation-space coordinates @coords.
+ *
+ * Return value: (transfer full): The shaping plan
+ *
+ * Since: 1.4.0
+ **/
+hb_shape_plan_t *
+hb_shape_plan_create2 (hb_face_t                     *face,
+		       const hb_segment_properties_t *props,
+		       const hb_feature_t            *user_features,
+		       unsigned int                   num_user_features,
+		       const int                     *coords,
+		       unsigned int                   num_coords,
+		       const char * const            *shaper_list)
+{
+  return _hb_shape_plan_create (face, props,
+				user_features, num_user_features,
+				coords, num_coords,
+				nullptr,
+				shaper_list);
+}
+
 /**
  * hb_shape_plan_get_empty:
  *
@@ -381,6 +427,38 @@ hb_shape_plan_get_shaper (hb_shape_plan_t *shape_plan)
 }
 
 
+bool
+hb_shape_plan_t::can_split_at_spaces (hb_font_t         *font,
+				      const hb_buffer_t *buffer) const
+{
+  /* We can split at spaces that no lookup can see.  That is, the lookups
+   * neither match nor skip over the space glyph, so nothing can happen
+   * across it.
+   *
+   * Lookups failing to match next to a space still mark it unsafe to concat
+   * though, which we cannot reproduce; don't split if asked for those.
+   * Neither can we reproduce the sequence of random alternates. */
+#ifndef HB_NO_OT_SHAPE
+  hb_codepoint_t space;
+  if (key.shaper_func != _hb_ot_shape ||
+      (buffer->flags & HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT) ||
+      ot.map.has_random_lookups () ||
+      !font->get_nominal_glyph (0x0020u, &space))
+    return false;
+#ifndef HB_DISABLE_DEPRECATED
+  if (ot.apply_fallback_kern &&
+      (HB_DIRECTION_IS_HORIZONTAL (buffer->props.direction) ?
+       font->has_glyph_h_kerning_func () :
+       font->has_glyph_v_kerning_func ()))
+    return false;
+#endif
+  return ot.glyph_is_untouched (font->face, space);
+#else
+  return false;
+#endif
+}
+
+
 static bool
 _hb_shape_plan_execute_internal (hb_shape_plan_t    *shape_plan,
 				 hb_font_t          *font,
@@ -461,6 +539,282 @@ hb_shape_plan_execute (hb_shape_plan_t    *shape_plan,
  * Caching
  */
 
+void
+hb_shape_plan_cache_t::init ()
+{
+  lock.init ();
+  table.init ();
+  epoch = 0;
+  readers[0] = readers[1] = 0;
+  retired_nodes[0] = retired_nodes[1] = nullptr;
+  retired_tables[0] = retired_tables[1] = nullptr;
+  most_recent = least_recent = nullptr;
+  population = 0;
+  capacity = HB_SHAPE_PLAN_CACHE_CAPACITY_DEFAULT;
+  policy = HB_SHAPE_PLAN_CACHE_POLICY_LRU;
+  hits = misses = evictions = 0;
+}
+
+void
+hb_shape_plan_cache_t::fini ()
+{
+  free_retired (0);
+  free_retired (1);
+  for (node_t *node = most_recent; node; )
+  {
+    node_t *next = node->next_used;
+    hb_shape_plan_destroy (node->shape_plan);
+    hb_free (node);
+    node = next;
+  }
+  most_recent = least_recent = nullptr;
+  population = 0;
+  hb_free (table.get_relaxed ());
+  table.init ();
+  lock.fini ();
+}
+
+void
+hb_shape_plan_cache_t::retire (node_t *node)
+{
+  unsigned parity = epoch.get_relaxed () & 1;
+  node->next_used = retired_nodes[parity];
+  retired_nodes[parity] = node;
+}
+
+void
+hb_shape_plan_cache_t::retire (table_t *t)
+{
+  unsigned parity = epoch.get_relaxed () & 1;
+  t->next_retired = retired_tables[parity];
+  retired_tables[parity] = t;
+}
+
+void
+hb_shape_plan_cache_t::free_retired (unsigned parity)
+{
+  for (node_t *node = retired_nodes[parity]; node; )
+  {
+    node_t *next = node->next_used;
+    hb_shape_plan_destroy (node->shape_plan);
+    hb_free (node);
+    node = next;
+  }
+  retired_nodes[parity] = nullptr;
+
+  for (table_t *t = retired_tables[parity]; t; )
+  {
+    table_t *next = t->next_retired;
+    hb_free (t);
+    t = next;
+  }
+  retired_tables[parity] = nullptr;
+}
+
+/* Frees what was retired in the previous epoch once no lookup of that
+ * epoch is running, then moves on from the current epoch if it retired
+ * anything.  Lookups of the new epoch cannot see what the current one
+ * retired, so that is freed as soon as the current lookups are done,
+ * here if they already are.  Must be called with the lock held. */
+void
+hb_shape_plan_cache_t::reclaim ()
+{
+  for (unsigned i = 0; i < 2; i++)
+  {
+    unsigned e = epoch.get_relaxed ();
+    unsigned previous = (e + 1) & 1;
+
+    _hb_memory_barrier ();
+    if (readers[previous].get_acquire ())
+      return;
+    free_retired (previous);
+
+    if (!retired_nodes[e & 1] && !retired_tables[e & 1])
+      return;
+    epoch.set_relaxed (e + 1);
+  }
+}
+
+hb_shape_plan_cache_t::node_t *
+hb_shape_plan_cache_t::lookup (const hb_shape_plan_key_t *key, uint32_t hash) const
+{
+  table_t *t = table.get_acquire ();
+  if (unlikely (!t))
+    return nullptr;
+
+  for (node_t *node = t->buckets ()[hash & (t->length - 1)].get_acquire (); node; node = node->next.get_acquire ())
+    if (node->hash == hash && node->shape_plan->key.equal (key))
+      return node;
+  return nullptr;
+}
+
+void
+hb_shape_plan_cache_t::unlink (node_t *node)
+{
+  if (node->prev_used) node->prev_used->next_used = node->next_used;
+  else most_recent = node->next_used;
+  if (node->next_used) node->next_used->prev_used = node->prev_used;
+  else least_recent = node->prev_used;
+  node->prev_used = node->next_used = nullptr;
+}
+
+void
+hb_shape_plan_cache_t::link (node_t *node)
+{
+  node->prev_used = nullptr;
+  node->next_used = most_recent;
+  if (most_recent) most_recent->prev_used = node;
+  most_recent = node;
+  if (!least_recent) least_recent = node;
+}
+
+void
+hb_shape_plan_cache_t::use (node_t *node)
+{
+  if (node == most_recent)
+    return;
+  unlink (node);
+  link (node);
+}
+
+void
+hb_shape_plan_cache_t::evict ()
+{
+  node_t *node = least_recent;
+  if (unlikely (!node))
+    return;
+
+  /* Second chance: move plans looked up since we last came by to the
+   * front.  Bounded, as lookups can keep marking nodes meanwhile. */
+  if (policy == HB_SHAPE_PLAN_CACHE_POLICY_LRU)
+    for (unsigned i = population; i && node->used.get_relaxed (); i--)
+    {
+      node->used.set_relaxed (0);
+      use (node);
+      node = least_recent;
+    }
+
+  unlink (node);
+  table_t *t = table.get_relaxed ();
+  for (hb_atomic_ptr_t<node_t> *p = &t->buckets ()[node->hash & (t->length - 1)]; p->get_relaxed (); p = &p->get_relaxed ()->next)
+    if (p->get_relaxed () == node)
+    {
+      p->set_release (node->next.get_relaxed ());
+      break;
+    }
+  population--;
+  evictions.inc ();
+
+  DEBUG_MSG_FUNC (SHAPE_PLAN, node->shape_plan, "evicted from cache");
+  retire (node);
+}
+
+bool
+hb_shape_plan_cache_t::resize ()
+{
+  table_t *old_table = table.get_relaxed ();
+  unsigned old_length = old_table ? old_table->length : 0;
+  if (likely (population < old_length))
+    return true;
+
+  unsigned new_length = hb_max (8u, old_length * 2);
+  table_t *new_table = (table_t *) hb_calloc (1, sizeof (table_t) + new_length * sizeof (hb_atomic_ptr_t<node_t>));
+  if (unlikely (!new_table))
+    return old_table; /* Keep going with longer chains. */
+  new_table->length = new_length;
+
+  /* Rechaining nodes under the feet of lookups can make them miss, but
+   * never loop: each chain they follow ends up in one of the new chains,
+   * which are only ever prepended to. */
+  for (node_t *node = most_recent; node; node = node->next_used)
+  {
+    hb_atomic_ptr_t<node_t> *bucket = &new_table->buckets ()[node->hash & (new_length - 1)];
+    node->next.set_release (bucket->get_relaxed ());
+    bucket->set_release (node);
+  }
+  table.set_release (new_table);
+
+  if (old_table)
+    retire (old_table);
+  return true;
+}
+
+hb_shape_plan_t *
+hb_shape_plan_cache_t::find (const hb_shape_plan_key_t *key, uint32_t hash)
+{
+  /* Count as a reader of the epoch current when we start looking, so
+   * that writers do not free anything we might see. */
+  int e;
+  for (;;)
+  {
+    e = epoch.get_relaxed ();
+    readers[e & 1].inc ();
+    _hb_memory_barrier ();
+    if (likely (epoch.get_relaxed () == e))
+      break;
+    readers[e & 1].dec ();
+  }
+
+  hb_shape_plan_t *shape_plan = nullptr;
+  node_t *node = lookup (key, hash);
+  if (node)
+  {
+    if (!node->used.get_relaxed ())
+      node->used.set_relaxed (1);
+    shape_plan = hb_shape_plan_reference (node->shape_plan);
+  }
+
+  readers[e & 1].dec ();
+
+  if (shape_plan) hits.inc (); else misses.inc ();
+  return shape_plan;
+}
+
+hb_shape_plan_t *
+hb_shape_plan_cache_t::insert (hb_shape_plan_t *shape_plan, uint32_t hash)
+{
+  hb_lock_t l (lock);
+
+  /* Another thread might have beaten us to it. */
+  node_t *node = lookup (&shape_plan->key, hash);
+  if (node)
+    return hb_shape_plan_reference (node->shape_plan);
+
+  if (unlikely (!resize ()))
+    return nullptr;
+
+  node = (node_t *) hb_calloc (1, sizeof (node_t));
+  if (unlikely (!node))
+    return nullptr;
+
+  node->shape_plan = hb_shape_plan_reference (shape_plan);
+  node->hash = hash;
+  table_t *t = table.get_relaxed ();
+  hb_atomic_ptr_t<node_t> *bucket = &t->buckets ()[hash & (t->length - 1)];
+  node->next.set_relaxed (bucket->get_relaxed ());
+  bucket->set_release (node);
+  link (node);
+  population++;
+
+  while (capacity && population > capacity)
+    evict ();
+  reclaim ();
+
+  return hb_shape_plan_reference (shape_plan);
+}
+
+void
+hb_shape_plan_cache_t::configure (unsigned capacity_, hb_shape_plan_cache_policy_t policy_)
+{
+  hb_lock_t l (lock);
+
+  capacity = capacity_;
+  policy = policy_;
+  while (capacity && population > capacity)
+    evict ();
+  reclaim ();
+}
+
 /**
  * hb_shape_plan_create_cached:
  * @face: #hb_face_t to use
@@ -489,32 +843,14 @@ hb_shape_plan_create_cached (hb_face_t                     *face,
 				       shaper_list);
 }
 
-/**
- * hb_shape_plan_create_cached2:
- * @face: #hb_face_t to use
- * @props: The #hb_segment_properties_t of the segment
- * @user_features: (array length=num_user_features): The list of user-selected features
- * @num_user_features: The number of user-selected features
- * @coords: (array length=num_coords): The list of variation-space coordinates
- * @num_coords: The number of variation-space coordinates
- * @shaper_list: (array zero-terminated=1): List of shapers to try
- *
- * The variable-font version of #hb_shape_plan_create_cached. 
- * Creates a cached shaping plan suitable for reuse, for a combination
- * of @face, @user_features, @props, and @shaper_list, plus the
- * variation-space coordinates @coords.
- *
- * Return value: (transfer full): The shaping plan
- *
- * Since: 1.4.0
- **/
-hb_shape_plan_t *
-hb_shape_plan_create_cached2 (hb_face_t                     *face,
+static hb_shape_plan_t *
+_hb_shape_plan_create_cached (hb_face_t                     *face,
 			      const hb_segment_properties_t *props,
 			      const hb_feature_t            *user_features,
 			      unsigned int                   num_user_features,
 			      const int                     *coords,
 			      unsigned int                   num_coords,
+			      const unsigned int            *variations_index,
 			      const char * const            *shaper_list)
 {
   DEBUG_MSG_FUNC (SHAPE_PLAN, nullptr,
@@ -523,11 +859,9 @@ hb_shape_plan_create_cached2 (hb_face_t                     *face,
 		  num_user_features,
 		  shaper_list);
 
-retry:
-  hb_face_t::plan_node_t *cached_plan_nodes = face->shape_plans;
-
   bool dont_cache = !hb_object_is_valid (face);
 
+  uint32_t hash = 0;
   if (likely (!dont_cache))
   {
     hb_shape_plan_key_t key;
@@ -538,39 +872,204 @@ retry:
 		   num_user_features,
 		   coords,
 		   num_coords,
+		   variations_index,
 		   shaper_list))
       return hb_shape_plan_get_empty ();
 
-    for (hb_face_t::plan_node_t *node = cached_plan_nodes; node; node = node->next)
-      if (node->shape_plan->key.equal (&key))
-      {
-	DEBUG_MSG_FUNC (SHAPE_PLAN, node->shape_plan, "fulfilled from cache");
-	return hb_shape_plan_reference (node->shape_plan);
-      }
+    hash = key.hash ();
+    hb_shape_plan_t *shape_plan = face->shape_plans.find (&key, hash);
+    if (shape_plan)
+    {
+      DEBUG_MSG_FUNC (SHAPE_PLAN, shape_plan, "fulfilled from cache");
+      return shape_plan;
+    }
   }
 
-  hb_shape_plan_t *shape_plan = hb_shape_plan_create2 (face, props,
-						       user_features, num_user_features,
-						       coords, num_coords,
-						       shaper_list);
+  hb_shape_plan_t *shape_plan = _hb_shape_plan_create (face, props,
+							user_features, num_user_features,
+							coords, num_coords,
+							variations_index,
+							shaper_list);
 
-  if (unlikely (dont_cache))
+  if (unlikely (dont_cache || !hb_object_is_valid (shape_plan)))
     return shape_plan;
 
-  hb_face_t::plan_node_t *node = (hb_face_t::plan_node_t *) hb_calloc (1, sizeof (hb_face_t::plan_node_t));
-  if (unlikely (!node))
+  hb_shape_plan_t *cached_plan = face->shape_plans.insert (shape_plan, hash);
+  if (unlikely (!cached_plan))
     return shape_plan;
+  hb_shape_plan_destroy (shape_plan);
+  DEBUG_MSG_FUNC (SHAPE_PLAN, cached_plan, "inserted into cache");
 
-  node->shape_plan = shape_plan;
-  node->next = cached_plan_nodes;
+  return cached_plan;
+}
 
-  if (unlikely (!face->shape_plans.cmpexch (cached_plan_nodes, node)))
+/**
+ * hb_shape_plan_create_cached2:
+ * @face: #hb_face_t to use
+ * @props: The #hb_segment_properties_t of the segment
+ * @user_features: (array length=num_user_features): The list of user-selected features
+ * @num_user_features: The number of user-selected features
+ * @coords: (array length=num_coords): The list of variation-space coordinates
+ * @num_coords: The number of variation-space coordinates
+ * @shaper_list: (array zero-terminated=1): List of shapers to try
+ *
+ * The variable-font version of #hb_shape_plan_create_cached. 
+ * Creates a cached shaping plan suitable for reuse, for a combination
+ * of @face, @user_features, @props, and @shaper_list, plus the
+ * variation-space coordinates @coords.
+ *
+ * The cache is bounded; see hb_face_set_shape_plan_cache().
+ *
+ * Return value: (transfer full): The shaping plan
+ *
+ * Since: 1.4.0
+ **/
+hb_shape_plan_t *
+hb_shape_plan_create_cached2 (hb_face_t                     *face,
+			      const hb_segment_properties_t *props,
+			      const hb_feature_t            *user_features,
+			      unsigned int                   num_user_features,
+			      const int                     *coords,
+			      unsigned int                   num_coords,
+			      const char * const            *shaper_list)
+{
+  return _hb_shape_plan_create_cached (face, props,
+				       user_features, num_user_features,
+				       coords, num_coords,
+				       nullptr,
+				       shaper_list);
+}
+
+/**
+ * hb_face_set_shape_plan_cache:
+ * @face: #hb_face_t to work upon
+ * @capacity: The maximum number of shape plans to keep, or zero for no limit
+ * @policy: Which plan to evict when the cache is full
+ *
+ * Configures the cache of shape plans that hb_shape_plan_create_cached2()
+ * and hb_shape() use for @face.  If the cache currently holds more than
+ * @capacity plans, the excess plans are evicted right away.
+ *
+ * Evicting a plan from the cache only drops the cache's reference to it;
+ * plans still in use elsewhere stay valid.
+ *
+ * The default capacity is 256 plans, with least-recently-used eviction.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_face_set_shape_plan_cache (hb_face_t                    *face,
+			      unsigned int                  capacity,
+			      hb_shape_plan_cache_policy_t  policy)
+{
+  if (unlikely (!hb_object_is_valid (face)))
+    return;
+
+  face->shape_plans.configure (capacity, policy);
+}
+
+/**
+ * hb_face_get_shape_plan_cache_stats:
+ * @face: #hb_face_t to work upon
+ * @hits: (out) (optional): Number of lookups satisfied from the cache
+ * @misses: (out) (optional): Number of lookups that had to create a new plan
+ * @evictions: (out) (optional): Number of plans evicted to stay within capacity
+ *
+ * Fetches the counters of the shape-plan cache of @face, accumulated since
+ * the face was created.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_face_get_shape_plan_cache_stats (hb_face_t    *face,
+				    unsigned int *hits,      /* OUT.  May be NULL. */
+				    unsigned int *misses,    /* OUT.  May be NULL. */
+				    unsigned int *evictions  /* OUT.  May be NULL. */)
+{
+  if (unlikely (!hb_object_is_valid (face)))
   {
-    hb_shape_plan_destroy (shape_plan);
-    hb_free (node);
-    goto retry;
+    if (hits) *hits = 0;
+    if (misses) *misses = 0;
+    if (evictions) *evictions = 0;
+    return;
   }
-  DEBUG_MSG_FUNC (SHAPE_PLAN, shape_plan, "inserted into cache");
 
-  return hb_shape_plan_reference (shape_plan);
+  hb_shape_plan_cache_t &cache = face->shape_plans;
+  if (hits) *hits = cache.hits.get_relaxed ();
+  if (misses) *misses = cache.misses.get_relaxed ();
+  if (evictions) *evictions = cache.evictions.get_relaxed ();
+}
+
+/**
+ * hb_face_prebuild_shape_plans:
+ * @face: #hb_face_t to work upon
+ * @props: The #hb_segment_properties_t of the segment
+ * @user_features: (array length=num_user_features): The list of user-selected features
+ * @num_user_features: The number of user-selected features
+ * @shaper_list: (array zero-terminated=1): List of shapers to try
+ *
+ * Creates, and adds to the shape-plan cache of @face, one shape plan for
+ * every distinct combination of GSUB and GPOS FeatureVariations records
+ * that can be selected by some variation coordinates.  After this call,
+ * hb_shape_plan_create_cached2() with the same arguments finds a cached
+ * plan at any coordinates.
+ *
+ * The shape-plan cache must be large enough to hold the plans for them to
+ * stay cached; see hb_face_set_shape_plan_cache().
+ *
+ * Return value: The number of shape plans created or found in the cache
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_face_prebuild_shape_plans (hb_face_t                     *face,
+			      const hb_segment_properties_t *props,
+			      const hb_feature_t            *user_features,
+			      unsigned int                   num_user_features,
+			      const char * const            *shaper_list)
+{
+  if (unlikely (!hb_object_is_valid (face)))
+    return 0;
+
+#ifndef HB_NO_OT_SHAPE
+  /* HB_OT_LAYOUT_NO_VARIATIONS_INDEX does not fit in a set. */
+  hb_vector_t<unsigned int> indices[2];
+  for (unsigned int table_index = 0; table_index < 2; table_index++)
+  {
+    hb_set_t set;
+    if (hb_ot_layout_table_collect_feature_variations (face,
+						       table_tags[table_index],
+						       &set))
+      indices[table_index].push (HB_OT_LAYOUT_NO_VARIATIONS_INDEX);
+    for (unsigned int index : set)
+      indices[table_index].push (index);
+    if (unlikely (set.in_error () || indices[table_index].in_error ()))
+      return 0;
+  }
+
+  unsigned int count = 0;
+  for (unsigned int gsub_index : indices[0])
+    for (unsigned int gpos_index : indices[1])
+    {
+      const unsigned int variations_index[2] = {gsub_index, gpos_index};
+      hb_shape_plan_t *shape_plan = _hb_shape_plan_create_cached (face, props,
+								  user_features, num_user_features,
+								  nullptr, 0,
+								  variations_index,
+								  shaper_list);
+      if (shape_plan != hb_shape_plan_get_empty ())
+	count++;
+      hb_shape_plan_destroy (shape_plan);
+    }
+  return count;
+#else
+  hb_shape_plan_t *shape_plan = _hb_shape_plan_create_cached (face, props,
+							      user_features, num_user_features,
+							      nullptr, 0,
+							      nullptr,
+							      shaper_list);
+  unsigned int count = shape_plan != hb_shape_plan_get_empty () ? 1 : 0;
+  hb_shape_plan_destroy (shape_plan);
+  return count;
+#endif
 }
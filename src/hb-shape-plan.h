@@ -117,6 +117,43 @@ HB_EXTERN const char *
 hb_shape_plan_get_shaper (hb_shape_plan_t *shape_plan);
 
 
+/**
+ * hb_shape_plan_cache_policy_t:
+ * @HB_SHAPE_PLAN_CACHE_POLICY_LRU: When the cache is full, a plan that
+ *   was not looked up recently is evicted.  Recency is approximated, so
+ *   that lookups do not have to lock the cache.
+ * @HB_SHAPE_PLAN_CACHE_POLICY_FIFO: When the cache is full, the plan that
+ *   was inserted first is evicted, regardless of how often it is used.
+ *
+ * The eviction policy of the per-face shape-plan cache used by
+ * hb_shape_plan_create_cached2().
+ *
+ * Since: REPLACEME
+ **/
+typedef enum {
+  HB_SHAPE_PLAN_CACHE_POLICY_LRU,
+  HB_SHAPE_PLAN_CACHE_POLICY_FIFO
+} hb_shape_plan_cache_policy_t;
+
+HB_EXTERN void
+hb_face_set_shape_plan_cache (hb_face_t                    *face,
+			      unsigned int                  capacity,
+			      hb_shape_plan_cache_policy_t  policy);
+
+HB_EXTERN void
+hb_face_get_shape_plan_cache_stats (hb_face_t    *face,
+				    unsigned int *hits,      /* OUT.  May be NULL. */
+				    unsigned int *misses,    /* OUT.  May be NULL. */
+				    unsigned int *evictions  /* OUT.  May be NULL. */);
+
+HB_EXTERN unsigned int
+hb_face_prebuild_shape_plans (hb_face_t                     *face,
+			      const hb_segment_properties_t *props,
+			      const hb_feature_t            *user_features,
+			      unsigned int                   num_user_features,
+			      const char * const            *shaper_list);
+
+
 HB_END_DECLS
 
 #endif /* HB_SHAPE_PLAN_H */
@@ -53,6 +53,7 @@ struct hb_shape_plan_key_t
 			 unsigned int                   num_user_features,
 			 const int                     *coords,
 			 unsigned int                   num_coords,
+			 const unsigned int            *variations_index, /* Overrides coords if not nullptr. */
 			 const char * const            *shaper_list);
 
   HB_INTERNAL void fini () { hb_free ((void *) user_features); user_features = nullptr; }
@@ -60,6 +61,8 @@ struct hb_shape_plan_key_t
   HB_INTERNAL bool user_features_match (const hb_shape_plan_key_t *other);
 
   HB_INTERNAL bool equal (const hb_shape_plan_key_t *other);
+
+  HB_INTERNAL uint32_t hash () const;
 };
 
 struct hb_shape_plan_t
@@ -71,6 +74,111 @@ struct hb_shape_plan_t
 #ifndef HB_NO_OT_SHAPE
   hb_ot_shape_plan_t ot;
 #endif
+
+  /* Whether @buffer can be split next to spaces, with the pieces shaped
+   * on their own and the results concatenated, without changing the
+   * outcome.  See _hb_shape_can_split_before() for where. */
+  HB_INTERNAL bool can_split_at_spaces (hb_font_t         *font,
+					const hb_buffer_t *buffer) const;
+};
+
+/* Characters that never start a piece of text of their own, such that we
+ * do not split before them.  They are also the ones context extends across. */
+static inline bool
+_hb_shape_is_continuation (hb_unicode_funcs_t *unicode,
+			   hb_codepoint_t      u)
+{
+  hb_unicode_general_category_t gen_cat = unicode->general_category (u);
+  return HB_UNICODE_GENERAL_CATEGORY_IS_MARK (gen_cat) ||
+	 gen_cat == HB_UNICODE_GENERAL_CATEGORY_FORMAT ||
+	 hb_in_range<hb_codepoint_t> (u, 0x1F3FBu, 0x1F3FFu); /* Emoji modifiers. */
+}
+
+/* Whether text can be split between @prev and @u, if the shape plan
+ * allows splitting at spaces at all. */
+static inline bool
+_hb_shape_can_split_before (hb_unicode_funcs_t *unicode,
+			    hb_codepoint_t      prev,
+			    hb_codepoint_t      u)
+{
+  return (prev == 0x0020u || u == 0x0020u) &&
+	 !_hb_shape_is_continuation (unicode, u);
+}
+
+
+#ifndef HB_SHAPE_PLAN_CACHE_CAPACITY_DEFAULT
+#define HB_SHAPE_PLAN_CACHE_CAPACITY_DEFAULT 256
+#endif
+
+/* Per-face cache of shape plans.  Plans are found through a hash of their
+ * key and kept on a usage list for eviction once the cache is full.
+ *
+ * Lookups do not take the lock: they walk the bucket chains counted as
+ * readers of the current epoch.  Writers, which do take the lock, put
+ * what they unlink on a retire list of the current epoch and move on to
+ * the next epoch.  A retire list is freed by a later writer once no reader
+ * of its epoch is left, or when the face is destroyed; writers never wait
+ * for readers.  Lookups only mark a node as used; eviction gives marked
+ * nodes a second chance, which approximates least-recently-used order. */
+struct hb_shape_plan_cache_t
+{
+  struct node_t
+  {
+    hb_shape_plan_t *shape_plan;
+    uint32_t hash;
+    hb_atomic_int_t used;	/* Looked up since eviction last passed it. */
+    hb_atomic_ptr_t<node_t> next;	/* Next in hash bucket. */
+    node_t *prev_used;	/* More recently used / inserted. */
+    node_t *next_used;	/* Less recently used / inserted; next retired. */
+  };
+
+  struct table_t
+  {
+    hb_atomic_ptr_t<node_t> *buckets () { return (hb_atomic_ptr_t<node_t> *) (this + 1); }
+
+    unsigned length;
+    table_t *next_retired;
+  };
+
+  ~hb_shape_plan_cache_t () { fini (); }
+
+  HB_INTERNAL void init ();
+  HB_INTERNAL void fini ();
+
+  /* Both return a new reference, or nullptr. */
+  HB_INTERNAL hb_shape_plan_t *find (const hb_shape_plan_key_t *key, uint32_t hash);
+  HB_INTERNAL hb_shape_plan_t *insert (hb_shape_plan_t *shape_plan, uint32_t hash);
+
+  HB_INTERNAL void configure (unsigned capacity, hb_shape_plan_cache_policy_t policy);
+
+  private:
+  node_t *lookup (const hb_shape_plan_key_t *key, uint32_t hash) const;
+  void link (node_t *node);
+  void use (node_t *node);
+  void unlink (node_t *node);
+  void evict ();
+  bool resize ();
+  void retire (node_t *node);
+  void retire (table_t *t);
+  void reclaim ();
+  void free_retired (unsigned parity);
+
+  public:
+  hb_mutex_t lock;
+  hb_atomic_ptr_t<table_t> table;
+  hb_atomic_int_t epoch;
+  hb_atomic_int_t readers[2];	/* Running lookups, by parity of their epoch. */
+  node_t *retired_nodes[2];	/* Unlinked, by parity of their epoch. */
+  table_t *retired_tables[2];
+  node_t *most_recent;
+  node_t *least_recent;
+  unsigned population;
+  unsigned capacity; /* Zero means unbounded. */
+  hb_shape_plan_cache_policy_t policy;
+
+  hb_atomic_int_t hits;
+  hb_atomic_int_t misses;
+  hb_atomic_int_t evictions;
 };
 
 
@@ -34,6 +34,13 @@
 #include "hb-font.hh"
 #include "hb-machinery.hh"
 
+#if !defined(HB_NO_MT) && defined(HAVE_PTHREAD)
+#include <pthread.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#endif
+
 
 /**
  * SECTION:hb-shape
@@ -101,6 +108,42 @@ hb_shape_list_shapers ()
 }
 
 
+static hb_bool_t
+_hb_shape_execute (hb_shape_plan_t    *shape_plan,
+		   hb_font_t          *font,
+		   hb_buffer_t        *buffer,
+		   const hb_feature_t *features,
+		   unsigned int        num_features,
+		   const char * const *shaper_list)
+{
+  hb_buffer_t *text_buffer = nullptr;
+  if (buffer->flags & HB_BUFFER_FLAG_VERIFY)
+  {
+    text_buffer = hb_buffer_create ();
+    hb_buffer_append (text_buffer, buffer, 0, -1);
+  }
+
+  hb_bool_t res = hb_shape_plan_execute (shape_plan, font, buffer, features, num_features);
+
+  if (buffer->max_ops <= 0)
+    buffer->shaping_failed = true;
+
+  if (text_buffer)
+  {
+    if (res && buffer->successful && !buffer->shaping_failed
+	    && text_buffer->successful
+	    && !buffer->verify (text_buffer,
+				font,
+				features,
+				num_features,
+				shaper_list))
+      res = false;
+    hb_buffer_destroy (text_buffer);
+  }
+
+  return res;
+}
+
 /**
  * hb_shape_full:
  * @font: an #hb_font_t to use for shaping
@@ -131,43 +174,708 @@ hb_shape_full (hb_font_t          *font,
 
   buffer->enter ();
 
-  hb_buffer_t *text_buffer = nullptr;
-  if (buffer->flags & HB_BUFFER_FLAG_VERIFY)
-  {
-    text_buffer = hb_buffer_create ();
-    hb_buffer_append (text_buffer, buffer, 0, -1);
-  }
-
   hb_shape_plan_t *shape_plan = hb_shape_plan_create_cached2 (font->face, &buffer->props,
 							      features, num_features,
 							      font->coords, font->num_coords,
 							      shaper_list);
 
-  hb_bool_t res = hb_shape_plan_execute (shape_plan, font, buffer, features, num_features);
+  hb_bool_t res = _hb_shape_execute (shape_plan, font, buffer, features, num_features, shaper_list);
 
-  if (buffer->max_ops <= 0)
-    buffer->shaping_failed = true;
+  hb_shape_plan_destroy (shape_plan);
+
+  buffer->leave ();
+
+  return res;
+}
+
+/**
+ * hb_shape_batch:
+ * @font: an #hb_font_t to use for shaping
+ * @buffers: (array length=num_buffers): an array of #hb_buffer_t to shape
+ * @num_buffers: the length of @buffers array
+ * @features: (array length=num_features) (nullable): an array of user
+ *    specified #hb_feature_t or `NULL`
+ * @num_features: the length of @features array
+ * @shaper_list: (array zero-terminated=1) (nullable): a `NULL`-terminated
+ *    array of shapers to use or `NULL`
+ *
+ * Shapes each of @buffers in turn, as if hb_shape_full() was called on
+ * each of them with the same @font, @features, and @shaper_list.
+ *
+ * This is faster than calling hb_shape_full() in a loop when shaping many
+ * short runs, since the shape plan is looked up once and reused for all
+ * consecutive buffers that share the same segment properties.
+ *
+ * Return value: false if all shapers failed for any of the buffers,
+ * true otherwise
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_shape_batch (hb_font_t          *font,
+		hb_buffer_t       **buffers,
+		unsigned int        num_buffers,
+		const hb_feature_t *features,
+		unsigned int        num_features,
+		const char * const *shaper_list)
+{
+  hb_bool_t ret = true;
+  hb_shape_plan_t *shape_plan = nullptr;
+
+  for (unsigned int i = 0; i < num_buffers; i++)
+  {
+    hb_buffer_t *buffer = buffers[i];
+    if (unlikely (!buffer->len))
+      continue;
+
+    buffer->enter ();
+
+    if (!shape_plan ||
+	!hb_segment_properties_equal (&shape_plan->key.props, &buffer->props))
+    {
+      hb_shape_plan_destroy (shape_plan);
+      shape_plan = hb_shape_plan_create_cached2 (font->face, &buffer->props,
+						 features, num_features,
+						 font->coords, font->num_coords,
+						 shaper_list);
+    }
+
+    if (!_hb_shape_execute (shape_plan, font, buffer, features, num_features, shaper_list))
+      ret = false;
+
+    buffer->leave ();
+  }
 
   hb_shape_plan_destroy (shape_plan);
 
-  if (text_buffer)
+  return ret;
+}
+
+/* Returns the start of the cluster before the one starting at @i. */
+static unsigned int
+_hb_shape_prev_cluster (const hb_glyph_info_t *info, unsigned int i)
+{
+  if (!i) return 0;
+  unsigned int cluster = info[--i].cluster;
+  while (i && info[i - 1].cluster == cluster)
+    i--;
+  return i;
+}
+
+/* Returns the start of the cluster after the one starting at @i. */
+static unsigned int
+_hb_shape_next_cluster (const hb_glyph_info_t *info, unsigned int len, unsigned int i)
+{
+  if (i == len) return len;
+  unsigned int cluster = info[i].cluster;
+  while (++i < len && info[i].cluster == cluster)
+    ;
+  return i;
+}
+
+/* Returns the first glyph at or after @i, at which text can be changed on
+ * one side without affecting the other. */
+static unsigned int
+_hb_shape_next_safe_cluster (const hb_glyph_info_t *info, unsigned int len, unsigned int i)
+{
+  while (i < len && (info[i].mask & HB_GLYPH_FLAG_UNSAFE_TO_CONCAT))
+    i = _hb_shape_next_cluster (info, len, i);
+  return i;
+}
+
+/**
+ * hb_shape_incremental:
+ * @font: an #hb_font_t to use for shaping
+ * @buffer: an #hb_buffer_t holding the shaped old text
+ * @text: (array length=text_length): the new text, as UTF-32
+ * @text_length: the length of @text
+ * @edit_start: where the edit starts in the old and new text
+ * @edit_end: where the edit ends in the old text
+ * @edit_length: the length of the edited text in @text
+ * @features: (array length=num_features) (nullable): an array of user
+ *    specified #hb_feature_t or `NULL`
+ * @num_features: the length of @features array
+ * @shaper_list: (array zero-terminated=1) (nullable): a `NULL`-terminated
+ *    array of shapers to use or `NULL`
+ *
+ * Updates @buffer after an edit of the text it was shaped from, replacing
+ * the text from @edit_start to @edit_end with @edit_length characters.
+ * The old text must have been added to @buffer in full, as with
+ * hb_buffer_add_utf32(), and shaped with
+ * #HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT set and a monotone cluster
+ * level, with the same @font, @features and @shaper_list.
+ *
+ * Only the glyphs around the edit are reshaped: the edit is extended to
+ * the nearest cluster boundaries that are not
+ * #HB_GLYPH_FLAG_UNSAFE_TO_CONCAT, both in the old glyphs and in the
+ * reshaped ones, and the result is spliced into @buffer.  Glyph infos and
+ * positions are the same as those of shaping @text from scratch.
+ *
+ * If @buffer does not meet the requirements above, all of @text is shaped.
+ *
+ * Return value: false if all shapers failed, true otherwise.  @buffer is
+ * not modified in that case.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_shape_incremental (hb_font_t          *font,
+		      hb_buffer_t        *buffer,
+		      const uint32_t     *text,
+		      unsigned int        text_length,
+		      unsigned int        edit_start,
+		      unsigned int        edit_end,
+		      unsigned int        edit_length,
+		      const hb_feature_t *features,
+		      unsigned int        num_features,
+		      const char * const *shaper_list)
+{
+  if (unlikely (hb_object_is_immutable (buffer) ||
+		edit_start > edit_end ||
+		edit_length > text_length - hb_min (edit_start, text_length)))
+    return false;
+
+  unsigned int old_length = text_length - edit_length + (edit_end - edit_start);
+  int delta = (int) edit_length - (int) (edit_end - edit_start);
+  bool backward = HB_DIRECTION_IS_BACKWARD (buffer->props.direction);
+
+  /* Glyphs [start, end) of @buffer are replaced. */
+  unsigned int start = 0, end = buffer->len;
+  bool incremental = buffer->content_type == HB_BUFFER_CONTENT_TYPE_GLYPHS &&
+		     (buffer->flags & HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT) &&
+		     buffer->cluster_level != HB_BUFFER_CLUSTER_LEVEL_CHARACTERS &&
+		     buffer->len;
+
+  /* Work in logical order. */
+  if (incremental && backward)
+    buffer->reverse ();
+
+  const hb_glyph_info_t *info = buffer->info;
+  unsigned int len = buffer->len;
+  if (incremental)
   {
-    if (res && buffer->successful && !buffer->shaping_failed
-	    && text_buffer->successful
-	    && !buffer->verify (text_buffer,
-				font,
-				features,
-				num_features,
-				shaper_list))
-      res = false;
-    hb_buffer_destroy (text_buffer);
+    /* The cluster containing edit_start, and the first one after edit_end. */
+    unsigned int lo = 0, hi = len;
+    while (lo < hi)
+    {
+      unsigned int mid = lo + (hi - lo) / 2;
+      if (info[mid].cluster <= edit_start) lo = mid + 1;
+      else hi = mid;
+    }
+    start = lo ? lo - 1 : 0;
+    while (start && info[start - 1].cluster == info[start].cluster)
+      start--;
+    end = start;
+    while (end < len && info[end].cluster < edit_end)
+      end++;
+
+    /* Include a cluster on either side of the edit; grapheme clustering,
+     * normalization, and fallback positioning do not set glyph flags,
+     * but do not reach further than the next cluster either. */
+    start = _hb_shape_prev_cluster (info, start);
+    end = _hb_shape_next_cluster (info, len, end);
   }
 
-  buffer->leave ();
+  hb_buffer_t *window = hb_buffer_create ();
+  hb_bool_t res = false;
+  while (true)
+  {
+    while (start && (info[start].mask & HB_GLYPH_FLAG_UNSAFE_TO_CONCAT))
+      start = _hb_shape_prev_cluster (info, start);
+    end = _hb_shape_next_safe_cluster (info, len, end);
+
+    /* Shape up to the safe cluster after the window as well, to see
+     * whether the new text is safe to concat at its end. */
+    unsigned int lookahead = end < len ? _hb_shape_next_safe_cluster (info, len, _hb_shape_next_cluster (info, len, end)) : len;
+    unsigned int text_start = start ? info[start].cluster : 0;
+    unsigned int text_end = (end < len ? info[end].cluster : old_length) + delta;
+    unsigned int text_lookahead = (lookahead < len ? info[lookahead].cluster : old_length) + delta;
+
+    hb_buffer_reset (window);
+    hb_buffer_set_unicode_funcs (window, buffer->unicode);
+    window->props = buffer->props;
+    window->flags = buffer->flags;
+    if (text_start)
+      window->flags = (hb_buffer_flags_t) (window->flags & ~HB_BUFFER_FLAG_BOT);
+    if (text_lookahead < text_length)
+      window->flags = (hb_buffer_flags_t) (window->flags & ~HB_BUFFER_FLAG_EOT);
+    window->cluster_level = buffer->cluster_level;
+    window->replacement = buffer->replacement;
+    window->invisible = buffer->invisible;
+    window->not_found = buffer->not_found;
+    if (!text_start)
+    {
+      window->context_len[0] = buffer->context_len[0];
+      hb_memcpy (window->context[0], buffer->context[0], sizeof (buffer->context[0]));
+    }
+    hb_buffer_add_utf32 (window, text, text_length, text_start, text_lookahead - text_start);
+    if (text_lookahead == text_length)
+    {
+      window->context_len[1] = buffer->context_len[1];
+      hb_memcpy (window->context[1], buffer->context[1], sizeof (buffer->context[1]));
+    }
+    if (unlikely (!window->successful))
+      break;
+
+    if (!hb_shape_full (font, window, features, num_features, shaper_list))
+      break;
+    if (backward)
+      window->reverse ();
+
+    /* Check that the new text is safe to concat at both ends, or extend
+     * the window and try again. */
+    const hb_glyph_info_t *window_info = window->info;
+    unsigned int window_len = window->len;
+    if (text_start && window_len &&
+	(window_info[0].mask & HB_GLYPH_FLAG_UNSAFE_TO_CONCAT))
+    {
+      start = _hb_shape_prev_cluster (info, start);
+      continue;
+    }
+    unsigned int window_end = window_len;
+    if (end < len)
+    {
+      window_end = 0;
+      while (window_end < window_len && window_info[window_end].cluster < text_end)
+	window_end++;
+      if (window_end == window_len ||
+	  window_info[window_end].cluster != text_end ||
+	  (window_info[window_end].mask & HB_GLYPH_FLAG_UNSAFE_TO_CONCAT))
+      {
+	end = lookahead;
+	continue;
+      }
+    }
+
+    /* Splice. */
+    unsigned int new_len = start + window_end + (len - end);
+    if (unlikely (!buffer->ensure (new_len)))
+      break;
+    info = buffer->info;
+    hb_glyph_position_t *pos = buffer->pos;
+    if (end < len)
+    {
+      memmove (buffer->info + start + window_end, info + end, (len - end) * sizeof (info[0]));
+      memmove (pos + start + window_end, pos + end, (len - end) * sizeof (pos[0]));
+      for (unsigned int i = start + window_end; i < new_len; i++)
+	buffer->info[i].cluster += delta;
+    }
+    hb_memcpy (buffer->info + start, window_info, window_end * sizeof (info[0]));
+    hb_memcpy (pos + start, window->pos, window_end * sizeof (pos[0]));
+    buffer->len = new_len;
+    if (!incremental)
+    {
+      buffer->content_type = window->content_type;
+      buffer->have_positions = window->have_positions;
+      buffer->props = window->props;
+    }
+    buffer->scratch_flags |= window->scratch_flags;
+    res = true;
+    break;
+  }
+  hb_buffer_destroy (window);
+
+  if (backward && (incremental || res))
+    buffer->reverse ();
+
+  return res;
+}
+
+#ifndef HB_SHAPE_PARALLEL_MIN_PIECE_LENGTH_DEFAULT
+#define HB_SHAPE_PARALLEL_MIN_PIECE_LENGTH_DEFAULT 4096
+#endif
+
+#ifndef HB_SHAPE_PARALLEL_MAX_PIECES
+#define HB_SHAPE_PARALLEL_MAX_PIECES 1024
+#endif
+
+#ifndef HB_SHAPE_PARALLEL_MAX_THREADS
+#define HB_SHAPE_PARALLEL_MAX_THREADS 64
+#endif
+
+struct hb_shape_parallel_t
+{
+  struct piece_t
+  {
+    unsigned int start, end;
+    hb_buffer_t *buffer;
+    bool res;
+  };
+
+  hb_shape_plan_t *shape_plan;
+  hb_font_t *font;
+  const hb_buffer_t *buffer;
+  const hb_feature_t *features;
+  unsigned int num_features;
+  hb_vector_t<piece_t> pieces;
+
+  /* Shapes piece @index on its own, with the text around it as context. */
+  static void shape_piece (void *data, unsigned int index)
+  {
+    const hb_shape_parallel_t *c = (const hb_shape_parallel_t *) data;
+    piece_t &piece = c->pieces.arrayZ[index];
+    const hb_buffer_t *buffer = c->buffer;
+    const hb_glyph_info_t *info = buffer->info;
+    hb_buffer_t *out = piece.buffer;
+
+    out->props = buffer->props;
+    unsigned int flags = buffer->flags & ~(HB_BUFFER_FLAG_BOT | HB_BUFFER_FLAG_EOT);
+    if (piece.start == 0)
+      flags |= buffer->flags & HB_BUFFER_FLAG_BOT;
+    if (piece.end == buffer->len)
+      flags |= buffer->flags & HB_BUFFER_FLAG_EOT;
+    out->flags = (hb_buffer_flags_t) flags;
+    out->cluster_level = buffer->cluster_level;
+    out->replacement = buffer->replacement;
+    out->invisible = buffer->invisible;
+    out->not_found = buffer->not_found;
+    out->content_type = HB_BUFFER_CONTENT_TYPE_UNICODE;
+
+    out->context_len[0] = out->context_len[1] = 0;
+    for (unsigned int i = piece.start; i && out->context_len[0] < hb_buffer_t::CONTEXT_LENGTH; )
+      out->context[0][out->context_len[0]++] = info[--i].codepoint;
+    for (unsigned int i = 0; i < buffer->context_len[0] && out->context_len[0] < hb_buffer_t::CONTEXT_LENGTH; i++)
+      out->context[0][out->context_len[0]++] = buffer->context[0][i];
+    for (unsigned int i = piece.end; i < buffer->len && out->context_len[1] < hb_buffer_t::CONTEXT_LENGTH; i++)
+      out->context[1][out->context_len[1]++] = info[i].codepoint;
+    for (unsigned int i = 0; i < buffer->context_len[1] && out->context_len[1] < hb_buffer_t::CONTEXT_LENGTH; i++)
+      out->context[1][out->context_len[1]++] = buffer->context[1][i];
+
+    for (unsigned int i = piece.start; i < piece.end; i++)
+      out->add (info[i].codepoint, info[i].cluster);
+    if (unlikely (!out->successful))
+      return;
+
+    out->enter ();
+    bool res = hb_shape_plan_execute (c->shape_plan, c->font, out, c->features, c->num_features);
+    if (out->max_ops <= 0)
+      out->shaping_failed = true;
+    out->leave ();
+    piece.res = res && out->successful && !out->shaping_failed;
+  }
+
+  /* Splits the text into pieces of at least @min_piece_length characters
+   * at places the shape plan allows.  Returns false if there would be
+   * only one. */
+  bool split (unsigned int min_piece_length)
+  {
+    unsigned int count = buffer->len;
+    if (count / 2 < min_piece_length ||
+	!shape_plan->can_split_at_spaces (font, buffer))
+      return false;
+    min_piece_length = hb_max (min_piece_length, count / HB_SHAPE_PARALLEL_MAX_PIECES + 1);
+
+    const hb_glyph_info_t *info = buffer->info;
+    unsigned int start = 0;
+    for (unsigned int i = min_piece_length; i + min_piece_length <= count; i++)
+    {
+      if (i - start < min_piece_length ||
+	  !_hb_shape_can_split_before (buffer->unicode, info[i - 1].codepoint, info[i].codepoint))
+	continue;
+      pieces.push (piece_t {start, i, nullptr, false});
+      start = i;
+    }
+    if (!start)
+      return false;
+    pieces.push (piece_t {start, count, nullptr, false});
+    return !pieces.in_error ();
+  }
+
+  /* Replaces the contents of @buffer with the glyphs of the pieces. */
+  static void assemble (hb_buffer_t          *buffer,
+			hb_array_t<piece_t>   pieces)
+  {
+    unsigned int num_glyphs = 0;
+    for (const piece_t &piece : pieces)
+      num_glyphs += piece.buffer->len;
+    if (unlikely (!buffer->ensure (num_glyphs)))
+      return;
+
+    buffer->len = num_glyphs;
+    buffer->clear_positions ();
+    buffer->content_type = HB_BUFFER_CONTENT_TYPE_GLYPHS;
+
+    bool backward = HB_DIRECTION_IS_BACKWARD (buffer->props.direction);
+    unsigned int j = 0;
+    for (unsigned int k = 0; k < pieces.length; k++)
+    {
+      const hb_buffer_t *out = pieces.arrayZ[backward ? pieces.length - 1 - k : k].buffer;
+      hb_memcpy (buffer->info + j, out->info, out->len * sizeof (out->info[0]));
+      hb_memcpy (buffer->pos + j, out->pos, out->len * sizeof (out->pos[0]));
+      buffer->scratch_flags |= out->scratch_flags;
+      j += out->len;
+    }
+  }
+};
+
+#if !defined(HB_NO_MT) && defined(HAVE_PTHREAD)
+/* The tasks of one hb_shape_parallel() call, which the calling thread and
+ * the pool threads take one at a time. */
+struct hb_shape_parallel_job_t
+{
+  hb_shape_parallel_task_func_t task;
+  void *task_data;
+  unsigned int num_tasks;
+  hb_atomic_int_t next;
+
+  void run ()
+  {
+    unsigned int i;
+    while ((i = (unsigned) next.inc ()) < num_tasks)
+      task (task_data, i);
+  }
+};
+
+/* Threads, one per processor besides the calling one, started on first
+ * use and kept waiting for jobs until the library is unloaded.  They run
+ * one job at a time. */
+struct hb_shape_parallel_pool_t
+{
+  hb_shape_parallel_pool_t ()
+  {
+    long num_processors = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+    num_processors = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+    unsigned int max_threads = (unsigned) hb_clamp (num_processors, 1L, (long) HB_SHAPE_PARALLEL_MAX_THREADS) - 1;
+
+    /* If a thread cannot be started, the others do its share. */
+    while (num_threads < max_threads &&
+	   !pthread_create (&threads[num_threads], nullptr, thread_func, this))
+      num_threads++;
+  }
+  ~hb_shape_parallel_pool_t ()
+  {
+    pthread_mutex_lock (&lock);
+    stopping = true;
+    pthread_cond_broadcast (&posted);
+    pthread_mutex_unlock (&lock);
+    for (unsigned int i = 0; i < num_threads; i++)
+      pthread_join (threads[i], nullptr);
+
+    pthread_cond_destroy (&finished);
+    pthread_cond_destroy (&posted);
+    pthread_mutex_destroy (&lock);
+  }
+
+  /* Runs @job on the pool threads and the calling one.  Returns false,
+   * without running anything, if the pool is busy with another job. */
+  bool run (hb_shape_parallel_job_t *job)
+  {
+    pthread_mutex_lock (&lock);
+    if (current || !num_threads)
+    {
+      pthread_mutex_unlock (&lock);
+      return false;
+    }
+    current = job;
+    generation++;
+    pending = num_threads;
+    pthread_cond_broadcast (&posted);
+    pthread_mutex_unlock (&lock);
+
+    job->run ();
+
+    pthread_mutex_lock (&lock);
+    while (pending)
+      pthread_cond_wait (&finished, &lock);
+    current = nullptr;
+    pthread_mutex_unlock (&lock);
+    return true;
+  }
+
+  private:
+  void work ()
+  {
+    unsigned int seen = 0;
+    pthread_mutex_lock (&lock);
+    for (;;)
+    {
+      while (!stopping && generation == seen)
+	pthread_cond_wait (&posted, &lock);
+      if (stopping)
+	break;
+      seen = generation;
+      hb_shape_parallel_job_t *job = current;
+      pthread_mutex_unlock (&lock);
+
+      job->run ();
+
+      pthread_mutex_lock (&lock);
+      if (!--pending)
+	pthread_cond_signal (&finished);
+    }
+    pthread_mutex_unlock (&lock);
+  }
+
+  static void *thread_func (void *data)
+  {
+    ((hb_shape_parallel_pool_t *) data)->work ();
+    return nullptr;
+  }
+
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+  pthread_cond_t posted = PTHREAD_COND_INITIALIZER;	/* A job was posted, or the pool is stopping. */
+  pthread_cond_t finished = PTHREAD_COND_INITIALIZER;	/* All threads are done with the job. */
+  pthread_t threads[HB_SHAPE_PARALLEL_MAX_THREADS];
+  unsigned int num_threads = 0;
+  hb_shape_parallel_job_t *current = nullptr;
+  unsigned int generation = 0;	/* Of jobs posted. */
+  unsigned int pending = 0;	/* Threads not done with the current job. */
+  bool stopping = false;
+};
+
+static void free_static_shape_parallel_pool ();
+
+static struct hb_shape_parallel_pool_lazy_loader_t : hb_lazy_loader_t<hb_shape_parallel_pool_t,
+								       hb_shape_parallel_pool_lazy_loader_t>
+{
+  static hb_shape_parallel_pool_t *create ()
+  {
+    hb_shape_parallel_pool_t *pool = (hb_shape_parallel_pool_t *) hb_calloc (1, sizeof (hb_shape_parallel_pool_t));
+    if (unlikely (!pool))
+      return nullptr;
+    new (pool) hb_shape_parallel_pool_t ();
+
+    hb_atexit (free_static_shape_parallel_pool);
+
+    return pool;
+  }
+  static const hb_shape_parallel_pool_t *get_null () { return nullptr; }
+} static_shape_parallel_pool;
+
+static inline
+void free_static_shape_parallel_pool ()
+{
+  static_shape_parallel_pool.free_instance ();
+}
+#endif
+
+/* Runs the tasks on the pool threads and the calling one; or one after
+ * another on the calling thread if threads are not available, or if the
+ * pool is busy with another call. */
+static void
+_hb_shape_parallel_dispatch_default (hb_shape_parallel_task_func_t  task,
+				     void                          *task_data,
+				     unsigned int                   num_tasks,
+				     void                          *user_data HB_UNUSED)
+{
+#if !defined(HB_NO_MT) && defined(HAVE_PTHREAD)
+  hb_shape_parallel_job_t job;
+  job.task = task;
+  job.task_data = task_data;
+  job.num_tasks = num_tasks;
+
+  hb_shape_parallel_pool_t *pool = num_tasks > 1 ? static_shape_parallel_pool.get_unconst () : nullptr;
+  if (!pool || !pool->run (&job))
+    job.run ();
+#else
+  for (unsigned int i = 0; i < num_tasks; i++)
+    task (task_data, i);
+#endif
+}
+
+/**
+ * hb_shape_parallel:
+ * @font: an #hb_font_t to use for shaping
+ * @buffer: an #hb_buffer_t to shape
+ * @features: (array length=num_features) (nullable): an array of user
+ *    specified #hb_feature_t or `NULL`
+ * @num_features: the length of @features array
+ * @shaper_list: (array zero-terminated=1) (nullable): a `NULL`-terminated
+ *    array of shapers to use or `NULL`
+ * @min_piece_length: the minimum number of characters to shape in one
+ *    task, or zero for the default
+ * @dispatch: (scope call) (nullable): the function to run the shaping
+ *    tasks with, or `NULL` to use threads that are started on first use,
+ *    one per processor, and kept until the library is unloaded
+ * @user_data: user data to pass to @dispatch
+ *
+ * Shapes @buffer like hb_shape_full() does, splitting long text into
+ * pieces that are shaped at the same time.
+ *
+ * The text is split next to U+0020 SPACE characters, if no lookup of the
+ * shape plan involves the space glyph, such that the result is the same
+ * as that of shaping all of @buffer at once.  The pieces are shaped on
+ * their own, by tasks run through @dispatch, and their glyphs are joined
+ * in order.
+ *
+ * If the text cannot be split, is shorter than twice @min_piece_length,
+ * @buffer asks for #HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT or
+ * #HB_BUFFER_FLAG_VERIFY, or a message function is set, @buffer is
+ * shaped with hb_shape_full() on the calling thread instead.
+ *
+ * @font and its font functions must be safe to use from multiple threads.
+ *
+ * Return value: false if all shapers failed, true otherwise
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_shape_parallel (hb_font_t                         *font,
+		   hb_buffer_t                       *buffer,
+		   const hb_feature_t                *features,
+		   unsigned int                       num_features,
+		   const char * const                *shaper_list,
+		   unsigned int                       min_piece_length,
+		   hb_shape_parallel_dispatch_func_t  dispatch,
+		   void                              *user_data)
+{
+  if (unlikely (!buffer->len))
+    return true;
+
+  if (buffer->content_type != HB_BUFFER_CONTENT_TYPE_UNICODE ||
+      (buffer->flags & HB_BUFFER_FLAG_VERIFY) ||
+      buffer->messaging ())
+    return hb_shape_full (font, buffer, features, num_features, shaper_list);
+
+  if (!min_piece_length)
+    min_piece_length = HB_SHAPE_PARALLEL_MIN_PIECE_LENGTH_DEFAULT;
+  if (!dispatch)
+    dispatch = _hb_shape_parallel_dispatch_default;
+
+  hb_shape_parallel_t c;
+  c.shape_plan = hb_shape_plan_create_cached2 (font->face, &buffer->props,
+					       features, num_features,
+					       font->coords, font->num_coords,
+					       shaper_list);
+  c.font = font;
+  c.buffer = buffer;
+  c.features = features;
+  c.num_features = num_features;
+
+  bool parallel = c.split (min_piece_length);
+  for (unsigned int i = 0; parallel && i < c.pieces.length; i++)
+  {
+    hb_buffer_t *out = c.pieces.arrayZ[i].buffer = hb_buffer_create ();
+    hb_buffer_set_unicode_funcs (out, buffer->unicode);
+    parallel = out->successful;
+  }
+
+  if (parallel)
+  {
+    dispatch (hb_shape_parallel_t::shape_piece, &c, c.pieces.length, user_data);
+    for (const auto &piece : c.pieces)
+      parallel = parallel && piece.res;
+  }
+
+  hb_bool_t res;
+  if (parallel)
+  {
+    hb_shape_parallel_t::assemble (buffer, c.pieces);
+    res = buffer->successful;
+  }
+  else
+    res = hb_shape_full (font, buffer, features, num_features, shaper_list);
+
+  for (const auto &piece : c.pieces)
+    hb_buffer_destroy (piece.buffer);
+  hb_shape_plan_destroy (c.shape_plan);
 
   return res;
 }
 
+
 /**
  * hb_shape:
  * @font: an #hb_font_t to use for shaping
@@ -53,6 +53,66 @@ hb_shape_full (hb_font_t          *font,
 	       unsigned int        num_features,
 	       const char * const *shaper_list);
 
+HB_EXTERN hb_bool_t
+hb_shape_batch (hb_font_t          *font,
+		hb_buffer_t       **buffers,
+		unsigned int        num_buffers,
+		const hb_feature_t *features,
+		unsigned int        num_features,
+		const char * const *shaper_list);
+
+HB_EXTERN hb_bool_t
+hb_shape_incremental (hb_font_t          *font,
+		      hb_buffer_t        *buffer,
+		      const uint32_t     *text,
+		      unsigned int        text_length,
+		      unsigned int        edit_start,
+		      unsigned int        edit_end,
+		      unsigned int        edit_length,
+		      const hb_feature_t *features,
+		      unsigned int        num_features,
+		      const char * const *shaper_list);
+
+/**
+ * hb_shape_parallel_task_func_t:
+ * @task_data: the data passed to the #hb_shape_parallel_dispatch_func_t
+ * @index: the index of the task to run
+ *
+ * A function that shapes one piece of a buffer.  Different tasks
+ * may run on different threads at the same time.
+ *
+ * Since: REPLACEME
+ **/
+typedef void (*hb_shape_parallel_task_func_t) (void         *task_data,
+					       unsigned int  index);
+
+/**
+ * hb_shape_parallel_dispatch_func_t:
+ * @task: the function to run
+ * @task_data: the data to pass to @task
+ * @num_tasks: the number of tasks
+ * @user_data: user data passed to hb_shape_parallel()
+ *
+ * A function that runs @task for each index from zero to @num_tasks,
+ * in any order and on any threads, and returns once all have finished.
+ *
+ * Since: REPLACEME
+ **/
+typedef void (*hb_shape_parallel_dispatch_func_t) (hb_shape_parallel_task_func_t  task,
+						   void                          *task_data,
+						   unsigned int                   num_tasks,
+						   void                          *user_data);
+
+HB_EXTERN hb_bool_t
+hb_shape_parallel (hb_font_t                         *font,
+		   hb_buffer_t                       *buffer,
+		   const hb_feature_t                *features,
+		   unsigned int                       num_features,
+		   const char * const                *shaper_list,
+		   unsigned int                       min_piece_length,
+		   hb_shape_parallel_dispatch_func_t  dispatch,
+		   void                              *user_data);
+
 HB_EXTERN const char **
 hb_shape_list_shapers (void);
 
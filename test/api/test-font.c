@@ -26,6 +26,10 @@
 
 #include "hb-test.h"
 
+#ifdef HAVE_FREETYPE
+#include <hb-ft.h>
+#endif
+
 /* Unit tests for hb-font.h */
 
 
@@ -598,6 +602,300 @@ test_font_properties (void)
   hb_font_destroy (subfont);
 }
 
+/* Glyphs 1..3 of the font have outlines, glyph 0 is empty, and glyph 4 is
+ * past the end of the font, so has no extents. */
+static const hb_codepoint_t extents_glyphs[] = {3, 1, 0, 2, 1, 4, 2, 3};
+#define EXTENTS_GLYPHS_FOUND 5
+
+static void
+check_glyph_extents_equal (const hb_glyph_extents_t *a,
+			   const hb_glyph_extents_t *b)
+{
+  g_assert_cmpint (a->x_bearing, ==, b->x_bearing);
+  g_assert_cmpint (a->y_bearing, ==, b->y_bearing);
+  g_assert_cmpint (a->width, ==, b->width);
+  g_assert_cmpint (a->height, ==, b->height);
+}
+
+static void
+check_glyph_extents_batch (hb_font_t *font)
+{
+  const unsigned int count = G_N_ELEMENTS (extents_glyphs);
+  hb_glyph_extents_t extents[G_N_ELEMENTS (extents_glyphs)];
+  hb_glyph_extents_t expected;
+  hb_glyph_extents_t zero = {0, 0, 0, 0};
+  unsigned int i;
+
+  /* Stops at the first glyph without extents, and zeroes it and the rest. */
+  memset (extents, 0x55, sizeof (extents));
+  g_assert_cmpuint (hb_font_get_glyph_extents_batch (font, count,
+						     extents_glyphs, sizeof (extents_glyphs[0]),
+						     extents, sizeof (extents[0])), ==, EXTENTS_GLYPHS_FOUND);
+  for (i = 0; i < EXTENTS_GLYPHS_FOUND; i++)
+  {
+    g_assert (hb_font_get_glyph_extents (font, extents_glyphs[i], &expected));
+    check_glyph_extents_equal (&extents[i], &expected);
+  }
+  g_assert (!hb_font_get_glyph_extents (font, extents_glyphs[i], &expected));
+  for (; i < count; i++)
+    check_glyph_extents_equal (&extents[i], &zero);
+
+  /* Interleaved glyphs and extents. */
+  {
+    struct { hb_codepoint_t glyph; hb_glyph_extents_t extents; } items[EXTENTS_GLYPHS_FOUND];
+    for (i = 0; i < EXTENTS_GLYPHS_FOUND; i++)
+      items[i].glyph = extents_glyphs[i];
+    g_assert_cmpuint (hb_font_get_glyph_extents_batch (font, EXTENTS_GLYPHS_FOUND,
+						       &items[0].glyph, sizeof (items[0]),
+						       &items[0].extents, sizeof (items[0])), ==, EXTENTS_GLYPHS_FOUND);
+    for (i = 0; i < EXTENTS_GLYPHS_FOUND; i++)
+      check_glyph_extents_equal (&items[i].extents, &extents[i]);
+  }
+
+  /* A zero glyph stride queries the same glyph again... */
+  memset (extents, 0x55, sizeof (extents));
+  g_assert_cmpuint (hb_font_get_glyph_extents_batch (font, 3,
+						     &extents_glyphs[3], 0,
+						     extents, sizeof (extents[0])), ==, 3);
+  g_assert (hb_font_get_glyph_extents (font, extents_glyphs[3], &expected));
+  for (i = 0; i < 3; i++)
+    check_glyph_extents_equal (&extents[i], &expected);
+
+  /* ...and a zero extents stride leaves the last glyph's extents. */
+  memset (extents, 0x55, sizeof (extents));
+  g_assert_cmpuint (hb_font_get_glyph_extents_batch (font, EXTENTS_GLYPHS_FOUND,
+						     extents_glyphs, sizeof (extents_glyphs[0]),
+						     extents, 0), ==, EXTENTS_GLYPHS_FOUND);
+  g_assert (hb_font_get_glyph_extents (font, extents_glyphs[EXTENTS_GLYPHS_FOUND - 1], &expected));
+  check_glyph_extents_equal (&extents[0], &expected);
+
+  g_assert_cmpuint (hb_font_get_glyph_extents_batch (font, 0,
+						     NULL, 0,
+						     NULL, 0), ==, 0);
+}
+
+/* The font maps U+0038, U+0039, U+00AE, and U+2049, but not U+20E3, in
+ * its default variation sequences with U+FE0F. */
+static const hb_codepoint_t variation_unicodes[] = {0x0038u, 0x00AEu, 0x0039u, 0x2049u, 0x0038u, 0x20E3u, 0x0039u};
+static const hb_codepoint_t variation_glyphs[] = {1, 3, 2, 4, 1};
+#define VARIATION_GLYPHS_FOUND 5
+
+static void
+check_variation_glyphs (hb_font_t *font)
+{
+  const unsigned int count = G_N_ELEMENTS (variation_unicodes);
+  hb_codepoint_t selectors[G_N_ELEMENTS (variation_unicodes)];
+  hb_codepoint_t glyphs[G_N_ELEMENTS (variation_unicodes)];
+  hb_codepoint_t selector = 0xFE0Fu;
+  hb_codepoint_t glyph;
+  unsigned int i;
+
+  for (i = 0; i < count; i++)
+    selectors[i] = selector;
+
+  g_assert_cmpuint (hb_font_get_variation_glyphs (font, count,
+						  variation_unicodes, sizeof (variation_unicodes[0]),
+						  selectors, sizeof (selectors[0]),
+						  glyphs, sizeof (glyphs[0])), ==, VARIATION_GLYPHS_FOUND);
+  for (i = 0; i < VARIATION_GLYPHS_FOUND; i++)
+  {
+    g_assert_cmpuint (glyphs[i], ==, variation_glyphs[i]);
+    g_assert (hb_font_get_variation_glyph (font, variation_unicodes[i], selector, &glyph));
+    g_assert_cmpuint (glyph, ==, glyphs[i]);
+  }
+  g_assert (!hb_font_get_variation_glyph (font, variation_unicodes[i], selector, &glyph));
+
+  /* A zero stride uses the same variation selector for all code points. */
+  memset (glyphs, 0, sizeof (glyphs));
+  g_assert_cmpuint (hb_font_get_variation_glyphs (font, count,
+						  variation_unicodes, sizeof (variation_unicodes[0]),
+						  &selector, 0,
+						  glyphs, sizeof (glyphs[0])), ==, VARIATION_GLYPHS_FOUND);
+  for (i = 0; i < VARIATION_GLYPHS_FOUND; i++)
+    g_assert_cmpuint (glyphs[i], ==, variation_glyphs[i]);
+
+  /* A zero glyph stride leaves the last glyph. */
+  g_assert_cmpuint (hb_font_get_variation_glyphs (font, VARIATION_GLYPHS_FOUND - 1,
+						  variation_unicodes, sizeof (variation_unicodes[0]),
+						  &selector, 0,
+						  &glyph, 0), ==, VARIATION_GLYPHS_FOUND - 1);
+  g_assert_cmpuint (glyph, ==, variation_glyphs[VARIATION_GLYPHS_FOUND - 2]);
+
+  /* Not a variation sequence at all. */
+  selector = 0xFE00u;
+  g_assert_cmpuint (hb_font_get_variation_glyphs (font, count,
+						  variation_unicodes, sizeof (variation_unicodes[0]),
+						  &selector, 0,
+						  glyphs, sizeof (glyphs[0])), ==, 0);
+}
+
+static hb_bool_t
+wrapped_glyph_extents_func (hb_font_t *font HB_UNUSED, void *font_data,
+			    hb_codepoint_t glyph,
+			    hb_glyph_extents_t *extents,
+			    void *user_data HB_UNUSED)
+{
+  return hb_font_get_glyph_extents ((hb_font_t *) font_data, glyph, extents);
+}
+
+static unsigned int
+wrapped_glyph_extents_batch_func (hb_font_t *font HB_UNUSED, void *font_data,
+				  unsigned int count,
+				  const hb_codepoint_t *first_glyph,
+				  unsigned int glyph_stride,
+				  hb_glyph_extents_t *first_extents,
+				  unsigned int extents_stride,
+				  void *user_data HB_UNUSED)
+{
+  return hb_font_get_glyph_extents_batch ((hb_font_t *) font_data, count,
+					  first_glyph, glyph_stride,
+					  first_extents, extents_stride);
+}
+
+static hb_bool_t
+wrapped_variation_glyph_func (hb_font_t *font HB_UNUSED, void *font_data,
+			      hb_codepoint_t unicode,
+			      hb_codepoint_t variation_selector,
+			      hb_codepoint_t *glyph,
+			      void *user_data HB_UNUSED)
+{
+  return hb_font_get_variation_glyph ((hb_font_t *) font_data, unicode, variation_selector, glyph);
+}
+
+static unsigned int
+wrapped_variation_glyphs_func (hb_font_t *font HB_UNUSED, void *font_data,
+			       unsigned int count,
+			       const hb_codepoint_t *first_unicode,
+			       unsigned int unicode_stride,
+			       const hb_codepoint_t *first_variation_selector,
+			       unsigned int variation_selector_stride,
+			       hb_codepoint_t *first_glyph,
+			       unsigned int glyph_stride,
+			       void *user_data HB_UNUSED)
+{
+  return hb_font_get_variation_glyphs ((hb_font_t *) font_data, count,
+				       first_unicode, unicode_stride,
+				       first_variation_selector, variation_selector_stride,
+				       first_glyph, glyph_stride);
+}
+
+/* A font that forwards one of the singular or batched callbacks, but not
+ * the other, to @font. */
+static hb_font_t *
+create_wrapped_font (hb_font_t *font, hb_bool_t batched)
+{
+  hb_font_funcs_t *ffuncs = hb_font_funcs_create ();
+  hb_font_t *wrapped = hb_font_create (hb_font_get_face (font));
+
+  if (batched)
+  {
+    hb_font_funcs_set_glyph_extents_batch_func (ffuncs, wrapped_glyph_extents_batch_func, NULL, NULL);
+    hb_font_funcs_set_variation_glyphs_func (ffuncs, wrapped_variation_glyphs_func, NULL, NULL);
+  }
+  else
+  {
+    hb_font_funcs_set_glyph_extents_func (ffuncs, wrapped_glyph_extents_func, NULL, NULL);
+    hb_font_funcs_set_variation_glyph_func (ffuncs, wrapped_variation_glyph_func, NULL, NULL);
+  }
+  hb_font_set_funcs (wrapped, ffuncs, hb_font_reference (font), (hb_destroy_func_t) hb_font_destroy);
+  hb_font_funcs_destroy (ffuncs);
+
+  return wrapped;
+}
+
+static void
+test_font_glyph_extents_batch (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_t *sub_font, *wrapped;
+  hb_glyph_extents_t extents[EXTENTS_GLYPHS_FOUND], sub_extents[EXTENTS_GLYPHS_FOUND];
+  unsigned int i;
+  hb_face_destroy (face);
+
+  check_glyph_extents_batch (font);
+  hb_font_get_glyph_extents_batch (font, EXTENTS_GLYPHS_FOUND,
+				   extents_glyphs, sizeof (extents_glyphs[0]),
+				   extents, sizeof (extents[0]));
+  g_assert_cmpint (extents[1].x_bearing, ==, 109);
+  g_assert_cmpint (extents[1].y_bearing, ==, 1102);
+  g_assert_cmpint (extents[1].width, ==, 893);
+  g_assert_cmpint (extents[1].height, ==, -1122);
+
+  /* Scaled from the parent font. */
+  sub_font = hb_font_create_sub_font (font);
+  hb_font_set_scale (sub_font, 2 * 2048, 2 * 2048);
+  check_glyph_extents_batch (sub_font);
+  g_assert_cmpuint (hb_font_get_glyph_extents_batch (sub_font, EXTENTS_GLYPHS_FOUND,
+						     extents_glyphs, sizeof (extents_glyphs[0]),
+						     sub_extents, sizeof (sub_extents[0])), ==, EXTENTS_GLYPHS_FOUND);
+  for (i = 0; i < EXTENTS_GLYPHS_FOUND; i++)
+  {
+    g_assert_cmpint (sub_extents[i].x_bearing, ==, 2 * extents[i].x_bearing);
+    g_assert_cmpint (sub_extents[i].y_bearing, ==, 2 * extents[i].y_bearing);
+    g_assert_cmpint (sub_extents[i].width, ==, 2 * extents[i].width);
+    g_assert_cmpint (sub_extents[i].height, ==, 2 * extents[i].height);
+  }
+  hb_font_destroy (sub_font);
+
+  /* Either callback implements the other. */
+  wrapped = create_wrapped_font (font, FALSE);
+  check_glyph_extents_batch (wrapped);
+  hb_font_destroy (wrapped);
+  wrapped = create_wrapped_font (font, TRUE);
+  check_glyph_extents_batch (wrapped);
+  hb_font_destroy (wrapped);
+
+  hb_font_destroy (font);
+}
+
+static void
+test_font_variation_glyphs (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoColorEmoji.cmap.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_t *sub_font, *wrapped;
+  hb_face_destroy (face);
+
+  check_variation_glyphs (font);
+
+  sub_font = hb_font_create_sub_font (font);
+  check_variation_glyphs (sub_font);
+  hb_font_destroy (sub_font);
+
+  wrapped = create_wrapped_font (font, FALSE);
+  check_variation_glyphs (wrapped);
+  hb_font_destroy (wrapped);
+  wrapped = create_wrapped_font (font, TRUE);
+  check_variation_glyphs (wrapped);
+  hb_font_destroy (wrapped);
+
+  hb_font_destroy (font);
+}
+
+#ifdef HAVE_FREETYPE
+static void
+test_font_batch_ft (void)
+{
+  hb_face_t *face;
+  hb_font_t *font;
+
+  face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  font = hb_font_create (face);
+  hb_face_destroy (face);
+  hb_ft_font_set_funcs (font);
+  check_glyph_extents_batch (font);
+  hb_font_destroy (font);
+
+  face = hb_test_open_font_file ("fonts/NotoColorEmoji.cmap.ttf");
+  font = hb_font_create (face);
+  hb_face_destroy (face);
+  hb_ft_font_set_funcs (font);
+  check_variation_glyphs (font);
+  hb_font_destroy (font);
+}
+#endif
+
 int
 main (int argc, char **argv)
 {
@@ -614,6 +912,11 @@ main (int argc, char **argv)
 
   hb_test_add (test_font_empty);
   hb_test_add (test_font_properties);
+  hb_test_add (test_font_glyph_extents_batch);
+  hb_test_add (test_font_variation_glyphs);
+#ifdef HAVE_FREETYPE
+  hb_test_add (test_font_batch_ft);
+#endif
 
   return hb_test_run();
 }
@@ -215,6 +215,95 @@ test_ot_layout_language_get_feature_tags (void)
   hb_face_destroy (face);
 }
 
+static void
+test_ot_shape_plan_profile (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoNastaliqUrdu-Regular.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_segment_properties_t props;
+  hb_shape_plan_t *plan;
+  hb_ot_shape_plan_lookup_profile_t lookups[STATIC_ARRAY_SIZE];
+  hb_ot_shape_plan_stage_profile_t stages[STATIC_ARRAY_SIZE];
+  unsigned int total, count, i;
+  unsigned int invocations = 0, applications = 0;
+
+  hb_buffer_add_utf8 (buffer, "\xd8\xa8\xd8\xb3\xd9\x85", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_buffer_get_segment_properties (buffer, &props);
+
+  plan = hb_shape_plan_create_cached (face, &props, NULL, 0, NULL);
+  count = STATIC_ARRAY_SIZE;
+  g_assert_cmpuint (0, ==, hb_ot_shape_plan_get_lookup_profiles (plan, 0, &count, lookups));
+  g_assert_cmpuint (0, ==, count);
+
+  g_assert (hb_ot_shape_plan_set_profiling (plan, TRUE));
+  g_assert (hb_ot_shape_plan_get_profiling (plan));
+  g_assert (hb_shape_plan_execute (plan, font, buffer, NULL, 0));
+
+  count = STATIC_ARRAY_SIZE;
+  total = hb_ot_shape_plan_get_lookup_profiles (plan, 0, &count, lookups);
+  g_assert_cmpuint (total, >, 0);
+  g_assert_cmpuint (total, ==, count);
+  for (i = 0; i < count; i++)
+  {
+    g_assert (lookups[i].table_tag == HB_OT_TAG_GSUB || lookups[i].table_tag == HB_OT_TAG_GPOS);
+    g_assert_cmpuint (lookups[i].applications, <=, lookups[i].glyphs_visited);
+    invocations += lookups[i].invocations;
+    applications += lookups[i].applications;
+  }
+  g_assert_cmpuint (invocations, ==, total);
+  g_assert_cmpuint (applications, >, 0);
+
+  count = 1;
+  g_assert_cmpuint (total, ==, hb_ot_shape_plan_get_lookup_profiles (plan, total - 1, &count, lookups));
+  g_assert_cmpuint (1, ==, count);
+  g_assert_cmpuint (HB_OT_TAG_GPOS, ==, lookups[0].table_tag);
+
+  count = STATIC_ARRAY_SIZE;
+  total = hb_ot_shape_plan_get_stage_profiles (plan, 0, &count, stages);
+  g_assert_cmpuint (total, >, 0);
+  for (i = 0; i < count; i++)
+  {
+    g_assert_cmpuint (1, ==, stages[i].invocations);
+    g_assert_cmpuint (stages[i].pause_time_ns, <=, stages[i].time_ns);
+  }
+
+  /* Executions add up. */
+  hb_buffer_clear_contents (buffer);
+  hb_buffer_add_utf8 (buffer, "\xd8\xa8\xd8\xb3\xd9\x85", -1, 0, -1);
+  hb_buffer_set_segment_properties (buffer, &props);
+  g_assert (hb_shape_plan_execute (plan, font, buffer, NULL, 0));
+
+  count = STATIC_ARRAY_SIZE;
+  g_assert_cmpuint (total, ==, hb_ot_shape_plan_get_stage_profiles (plan, 0, &count, stages));
+  for (i = 0; i < count; i++)
+    g_assert_cmpuint (2, ==, stages[i].invocations);
+
+  count = STATIC_ARRAY_SIZE;
+  hb_ot_shape_plan_get_lookup_profiles (plan, 0, &count, lookups);
+  for (i = 0; i < count; i++)
+    g_assert_cmpuint (2, ==, lookups[i].invocations);
+
+  hb_ot_shape_plan_reset_profile (plan);
+  g_assert (hb_ot_shape_plan_set_profiling (plan, FALSE));
+  g_assert (!hb_ot_shape_plan_get_profiling (plan));
+  hb_buffer_clear_contents (buffer);
+  hb_buffer_add_utf8 (buffer, "\xd8\xa8\xd8\xb3\xd9\x85", -1, 0, -1);
+  hb_buffer_set_segment_properties (buffer, &props);
+  g_assert (hb_shape_plan_execute (plan, font, buffer, NULL, 0));
+
+  count = STATIC_ARRAY_SIZE;
+  hb_ot_shape_plan_get_lookup_profiles (plan, 0, &count, lookups);
+  for (i = 0; i < count; i++)
+    g_assert_cmpuint (0, ==, lookups[i].invocations);
+
+  hb_shape_plan_destroy (plan);
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -224,5 +313,6 @@ main (int argc, char **argv)
   hb_test_add (test_ot_layout_script_get_language_tags);
   hb_test_add (test_ot_layout_table_get_feature_tags);
   hb_test_add (test_ot_layout_language_get_feature_tags);
+  hb_test_add (test_ot_shape_plan_profile);
   return hb_test_run ();
 }
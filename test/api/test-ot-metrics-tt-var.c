@@ -61,6 +61,82 @@ test_extents_tt_var (void)
   hb_font_destroy (font);
 }
 
+static void
+check_extents (hb_font_t *font, hb_codepoint_t glyph,
+	       int x_bearing, int y_bearing, int width, int height)
+{
+  hb_glyph_extents_t extents;
+  g_assert (hb_font_get_glyph_extents (font, glyph, &extents));
+  g_assert_cmpint (extents.x_bearing, ==, x_bearing);
+  g_assert_cmpint (extents.y_bearing, ==, y_bearing);
+  g_assert_cmpint (extents.width, ==, width);
+  g_assert_cmpint (extents.height, ==, height);
+}
+
+static void
+check_extents_cache_misses (hb_font_t *font, unsigned int expected)
+{
+  unsigned int hits, misses;
+  hb_ot_font_get_glyph_extents_cache_stats (font, &hits, &misses);
+  g_assert_cmpuint (misses, ==, expected);
+}
+
+static void
+test_extents_tt_var_cache (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/SourceSansVariable-Roman-nohvar-41,C1.ttf");
+  g_assert (face);
+  hb_font_t *font = hb_font_create (face);
+  hb_face_destroy (face);
+  g_assert (font);
+  hb_ot_font_set_funcs (font);
+
+  unsigned int hits = 1, misses = 1;
+  hb_ot_font_get_glyph_extents_cache_stats (font, &hits, &misses);
+  g_assert_cmpuint (hits, ==, 0);
+  g_assert_cmpuint (misses, ==, 0);
+  hb_ot_font_get_glyph_extents_cache_stats (font, NULL, NULL);
+
+  check_extents (font, 2, 10, 846, 500, -846);
+  check_extents_cache_misses (font, 1);
+  check_extents (font, 2, 10, 846, 500, -846);
+  check_extents_cache_misses (font, 1);
+
+  /* Hits are only counted in builds that ask for them. */
+  hb_ot_font_get_glyph_extents_cache_stats (font, &hits, NULL);
+  g_assert (hits == 0 || hits == 1);
+
+  /* Cached extents are scaled, so a new scale must not return them... */
+  hb_font_set_scale (font, 2000, 2000);
+  check_extents (font, 2, 20, 1692, 1000, -1692);
+  check_extents_cache_misses (font, 2);
+  check_extents (font, 2, 20, 1692, 1000, -1692);
+  check_extents_cache_misses (font, 2);
+
+  /* ...and neither must new variation coordinates. */
+  hb_font_set_scale (font, 1000, 1000);
+  float coords[1] = { 500.0f };
+  hb_font_set_var_coords_design (font, coords, 1);
+  check_extents (font, 2, 0, 874, 551, -874);
+  check_extents_cache_misses (font, 3);
+  check_extents (font, 2, 0, 874, 551, -874);
+  check_extents_cache_misses (font, 3);
+
+  hb_font_set_var_coords_design (font, NULL, 0);
+  check_extents (font, 2, 10, 846, 500, -846);
+  check_extents_cache_misses (font, 4);
+
+  /* Fonts not using the OpenType font functions have no cache. */
+  hb_font_t *sub_font = hb_font_create_sub_font (font);
+  check_extents (sub_font, 2, 10, 846, 500, -846);
+  hb_ot_font_get_glyph_extents_cache_stats (sub_font, &hits, &misses);
+  g_assert_cmpuint (hits, ==, 0);
+  g_assert_cmpuint (misses, ==, 0);
+  hb_font_destroy (sub_font);
+
+  hb_font_destroy (font);
+}
+
 static void
 test_advance_tt_var_nohvar (void)
 {
@@ -257,6 +333,7 @@ main (int argc, char **argv)
   hb_test_init (&argc, &argv);
 
   hb_test_add (test_extents_tt_var);
+  hb_test_add (test_extents_tt_var_cache);
   hb_test_add (test_advance_tt_var_nohvar);
   hb_test_add (test_advance_tt_var_hvarvvar);
   hb_test_add (test_advance_tt_var_anchor);
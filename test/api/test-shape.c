@@ -26,6 +26,8 @@
 
 #include "hb-test.h"
 
+#include <hb-ot.h>
+
 /* Unit tests for hb-shape.h */
 
 /*
@@ -138,6 +140,490 @@ test_shape (void)
   hb_font_destroy (font);
 }
 
+static void
+test_shape_batch (void)
+{
+  hb_blob_t *blob;
+  hb_face_t *face;
+  hb_font_funcs_t *ffuncs;
+  hb_font_t *font;
+  hb_buffer_t *buffers[3];
+  unsigned int i;
+
+  blob = hb_blob_create (test_data, sizeof (test_data), HB_MEMORY_MODE_READONLY, NULL, NULL);
+  face = hb_face_create (blob, 0);
+  hb_blob_destroy (blob);
+  font = hb_font_create (face);
+  hb_face_destroy (face);
+  hb_font_set_scale (font, 10, 10);
+
+  ffuncs = hb_font_funcs_create ();
+  hb_font_funcs_set_glyph_h_advance_func (ffuncs, glyph_h_advance_func, NULL, NULL);
+  hb_font_funcs_set_nominal_glyph_func (ffuncs, glyph_func, NULL, NULL);
+  hb_font_set_funcs (font, ffuncs, NULL, NULL);
+  hb_font_funcs_destroy (ffuncs);
+
+  for (i = 0; i < 3; i++)
+    buffers[i] = hb_buffer_create ();
+
+  hb_buffer_set_direction (buffers[0], HB_DIRECTION_LTR);
+  hb_buffer_add_utf8 (buffers[0], TesT, 4, 0, 4);
+  /* Empty buffer in the middle should be skipped. */
+  hb_buffer_set_direction (buffers[1], HB_DIRECTION_LTR);
+  /* Different segment properties than the first buffer. */
+  hb_buffer_set_direction (buffers[2], HB_DIRECTION_RTL);
+  hb_buffer_add_utf8 (buffers[2], TesT, 4, 1, 2);
+
+  g_assert (hb_shape_batch (font, buffers, 3, NULL, 0, NULL));
+
+  {
+    const hb_codepoint_t output_glyphs[] = {1, 2, 3, 1};
+    unsigned int len = hb_buffer_get_length (buffers[0]);
+    hb_glyph_info_t *glyphs = hb_buffer_get_glyph_infos (buffers[0], NULL);
+    g_assert_cmpint (len, ==, 4);
+    for (i = 0; i < len; i++)
+    {
+      g_assert_cmphex (glyphs[i].codepoint, ==, output_glyphs[i]);
+      g_assert_cmphex (glyphs[i].cluster,   ==, i);
+    }
+  }
+
+  g_assert_cmpint (hb_buffer_get_length (buffers[1]), ==, 0);
+
+  {
+    const hb_codepoint_t output_glyphs[] = {3, 2};
+    const hb_position_t output_x_advances[] = {5, 6};
+    unsigned int len = hb_buffer_get_length (buffers[2]);
+    hb_glyph_info_t *glyphs = hb_buffer_get_glyph_infos (buffers[2], NULL);
+    hb_glyph_position_t *positions = hb_buffer_get_glyph_positions (buffers[2], NULL);
+    g_assert_cmpint (len, ==, 2);
+    for (i = 0; i < len; i++)
+    {
+      g_assert_cmphex (glyphs[i].codepoint, ==, output_glyphs[i]);
+      g_assert_cmphex (glyphs[i].cluster,   ==, 2 - i);
+      g_assert_cmpint (positions[i].x_advance, ==, output_x_advances[i]);
+    }
+  }
+
+  for (i = 0; i < 3; i++)
+    hb_buffer_destroy (buffers[i]);
+  hb_font_destroy (font);
+}
+
+static void
+test_shape_plan_cache (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  hb_segment_properties_t props = HB_SEGMENT_PROPERTIES_DEFAULT;
+  hb_feature_t features[3];
+  hb_shape_plan_t *plans[3], *shape_plan;
+  unsigned int hits, misses, evictions;
+  unsigned int i;
+
+  props.direction = HB_DIRECTION_LTR;
+  props.script = HB_SCRIPT_LATIN;
+  g_assert (hb_feature_from_string ("-kern", -1, &features[0]));
+  g_assert (hb_feature_from_string ("-liga", -1, &features[1]));
+  g_assert (hb_feature_from_string ("smcp", -1, &features[2]));
+
+  hb_face_set_shape_plan_cache (face, 2, HB_SHAPE_PLAN_CACHE_POLICY_LRU);
+
+  for (i = 0; i < 2; i++)
+    plans[i] = hb_shape_plan_create_cached (face, &props, &features[i], 1, NULL);
+  hb_face_get_shape_plan_cache_stats (face, &hits, &misses, &evictions);
+  g_assert_cmpuint (hits, ==, 0);
+  g_assert_cmpuint (misses, ==, 2);
+  g_assert_cmpuint (evictions, ==, 0);
+
+  /* Touch the first plan, so that the second one is evicted next. */
+  g_assert (hb_shape_plan_create_cached (face, &props, &features[0], 1, NULL) == plans[0]);
+  hb_shape_plan_destroy (plans[0]);
+
+  plans[2] = hb_shape_plan_create_cached (face, &props, &features[2], 1, NULL);
+  hb_face_get_shape_plan_cache_stats (face, &hits, &misses, &evictions);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 3);
+  g_assert_cmpuint (evictions, ==, 1);
+
+  g_assert (hb_shape_plan_create_cached (face, &props, &features[0], 1, NULL) == plans[0]);
+  hb_shape_plan_destroy (plans[0]);
+  /* The evicted plan is still usable, but no longer returned from the cache. */
+  shape_plan = hb_shape_plan_create_cached (face, &props, &features[1], 1, NULL);
+  g_assert (shape_plan != plans[1]);
+  hb_shape_plan_destroy (shape_plan);
+  hb_face_get_shape_plan_cache_stats (face, &hits, &misses, &evictions);
+  g_assert_cmpuint (hits, ==, 2);
+  g_assert_cmpuint (misses, ==, 4);
+  g_assert_cmpuint (evictions, ==, 2);
+
+  hb_face_set_shape_plan_cache (face, 1, HB_SHAPE_PLAN_CACHE_POLICY_FIFO);
+  hb_face_get_shape_plan_cache_stats (face, NULL, NULL, &evictions);
+  g_assert_cmpuint (evictions, ==, 3);
+
+  for (i = 0; i < 3; i++)
+    hb_shape_plan_destroy (plans[i]);
+  hb_face_destroy (face);
+}
+
+static void
+test_shape_plan_prebuild (void)
+{
+  /* The one GSUB FeatureVariations record of this font applies from
+   * wght=800, normalized -0.2, up to the default. */
+  hb_face_t *face = hb_test_open_font_file ("fonts/AdobeVFPrototype-Subset.otf");
+  hb_segment_properties_t props = HB_SEGMENT_PROPERTIES_DEFAULT;
+  const struct {
+    int coord;
+    unsigned int variations_index;
+  } tests[] = {
+    {-16384, HB_OT_LAYOUT_NO_VARIATIONS_INDEX},
+    { -3278, HB_OT_LAYOUT_NO_VARIATIONS_INDEX},
+    { -3277, 0},
+    { -3276, 0},
+    {     0, 0},
+    {     1, HB_OT_LAYOUT_NO_VARIATIONS_INDEX},
+    { 16384, HB_OT_LAYOUT_NO_VARIATIONS_INDEX},
+  };
+  hb_shape_plan_t *plans[2] = {NULL, NULL};
+  unsigned int hits, misses, prebuilt_misses;
+  unsigned int i;
+
+  props.direction = HB_DIRECTION_LTR;
+  props.script = HB_SCRIPT_LATIN;
+
+  /* One plan with the record, and one without. */
+  g_assert_cmpuint (hb_face_prebuild_shape_plans (face, &props, NULL, 0, NULL), ==, 2);
+  hb_face_get_shape_plan_cache_stats (face, &hits, &prebuilt_misses, NULL);
+  g_assert_cmpuint (hits, ==, 0);
+  g_assert_cmpuint (prebuilt_misses, ==, 2);
+
+  for (i = 0; i < G_N_ELEMENTS (tests); i++)
+  {
+    unsigned int variations_index;
+    hb_shape_plan_t *shape_plan;
+    unsigned int slot;
+
+    hb_ot_layout_table_find_feature_variations (face, HB_OT_TAG_GSUB,
+						&tests[i].coord, 1,
+						&variations_index);
+    g_assert_cmpuint (variations_index, ==, tests[i].variations_index);
+
+    shape_plan = hb_shape_plan_create_cached2 (face, &props, NULL, 0,
+					       &tests[i].coord, 1, NULL);
+    slot = variations_index == HB_OT_LAYOUT_NO_VARIATIONS_INDEX ? 0 : 1;
+    if (!plans[slot])
+      plans[slot] = hb_shape_plan_reference (shape_plan);
+    g_assert (shape_plan == plans[slot]);
+    hb_shape_plan_destroy (shape_plan);
+  }
+  g_assert (plans[0] != plans[1]);
+
+  /* All of them were prebuilt. */
+  hb_face_get_shape_plan_cache_stats (face, &hits, &misses, NULL);
+  g_assert_cmpuint (hits, ==, G_N_ELEMENTS (tests));
+  g_assert_cmpuint (misses, ==, prebuilt_misses);
+
+  for (i = 0; i < 2; i++)
+    hb_shape_plan_destroy (plans[i]);
+  hb_face_destroy (face);
+}
+
+/* Asserts that @buffer holds the same glyphs as @expected, which was
+ * shaped with hb_shape(). */
+static void
+assert_buffers_equal (hb_buffer_t *buffer, hb_buffer_t *expected)
+{
+  unsigned int len = hb_buffer_get_length (expected);
+  hb_glyph_info_t *infos = hb_buffer_get_glyph_infos (buffer, NULL);
+  hb_glyph_position_t *positions = hb_buffer_get_glyph_positions (buffer, NULL);
+  hb_glyph_info_t *expected_infos = hb_buffer_get_glyph_infos (expected, NULL);
+  hb_glyph_position_t *expected_positions = hb_buffer_get_glyph_positions (expected, NULL);
+  unsigned int i;
+
+  g_assert_cmpuint (hb_buffer_get_length (buffer), ==, len);
+  for (i = 0; i < len; i++)
+  {
+    g_assert_cmphex (infos[i].codepoint, ==, expected_infos[i].codepoint);
+    g_assert_cmpuint (infos[i].cluster, ==, expected_infos[i].cluster);
+    g_assert_cmphex (hb_glyph_info_get_glyph_flags (&infos[i]), ==,
+		     hb_glyph_info_get_glyph_flags (&expected_infos[i]));
+    g_assert_cmpint (positions[i].x_advance, ==, expected_positions[i].x_advance);
+    g_assert_cmpint (positions[i].y_advance, ==, expected_positions[i].y_advance);
+    g_assert_cmpint (positions[i].x_offset, ==, expected_positions[i].x_offset);
+    g_assert_cmpint (positions[i].y_offset, ==, expected_positions[i].y_offset);
+  }
+}
+
+static hb_buffer_t *
+create_buffer (const char *text, hb_direction_t direction)
+{
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_buffer_add_utf8 (buffer, text, -1, 0, -1);
+  hb_buffer_set_direction (buffer, direction);
+  hb_buffer_set_script (buffer, HB_SCRIPT_LATIN);
+  return buffer;
+}
+
+/* Shapes @text with @cache and checks the result against hb_shape(). */
+static void
+check_shape_cache (hb_shape_cache_t *cache, hb_font_t *font, const char *text,
+		   const hb_feature_t *features, unsigned int num_features)
+{
+  hb_buffer_t *expected = create_buffer (text, HB_DIRECTION_LTR);
+  hb_buffer_t *buffer = create_buffer (text, HB_DIRECTION_LTR);
+
+  hb_shape (font, expected, features, num_features);
+  g_assert (hb_shape_cache_shape (cache, font, buffer, features, num_features, NULL));
+  assert_buffers_equal (buffer, expected);
+
+  hb_buffer_destroy (buffer);
+  hb_buffer_destroy (expected);
+}
+
+static void
+test_shape_cache (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abcAE.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_shape_cache_t *cache = hb_shape_cache_create (0);
+  const char *text = "ab abc ab";
+  unsigned int hits, misses, first_misses;
+  unsigned int round;
+  hb_face_destroy (face);
+
+  for (round = 0; round < 2; round++)
+  {
+    check_shape_cache (cache, font, text, NULL, 0);
+
+    hb_shape_cache_get_stats (cache, &hits, &misses);
+    if (round == 0)
+    {
+      /* Words are only shaped once, whatever the number of runs. */
+      g_assert_cmpuint (hits, <, misses);
+      first_misses = misses;
+    }
+    else
+    {
+      g_assert_cmpuint (misses, ==, first_misses);
+      g_assert_cmpuint (hits, >=, first_misses);
+    }
+  }
+
+  hb_shape_cache_clear (cache);
+  check_shape_cache (cache, font, text, NULL, 0);
+  hb_shape_cache_get_stats (cache, &hits, &misses);
+  g_assert_cmpuint (misses, >, first_misses);
+
+  /* Verifying buffers bypass the cache. */
+  {
+    unsigned int verify_hits, verify_misses;
+    hb_buffer_t *buffer = create_buffer (text, HB_DIRECTION_LTR);
+    hb_buffer_set_flags (buffer, HB_BUFFER_FLAG_VERIFY);
+    g_assert (hb_shape_cache_shape (cache, font, buffer, NULL, 0, NULL));
+    hb_buffer_destroy (buffer);
+    hb_shape_cache_get_stats (cache, &verify_hits, &verify_misses);
+    g_assert_cmpuint (verify_hits, ==, hits);
+    g_assert_cmpuint (verify_misses, ==, misses);
+  }
+
+  hb_shape_cache_destroy (cache);
+  hb_font_destroy (font);
+
+  /* Features that apply to part of the text select glyphs by cluster, so
+   * must not reuse words shaped elsewhere in the text. */
+  face = hb_test_open_font_file ("fonts/automatic-fractions.ttf");
+  font = hb_font_create (face);
+  cache = hb_shape_cache_create (0);
+  hb_face_destroy (face);
+  {
+    hb_feature_t features[2];
+    g_assert (hb_feature_from_string ("dnom", -1, &features[0]));
+    check_shape_cache (cache, font, "123 123 123", features, 1);
+    check_shape_cache (cache, font, "123 123 123", features, 1);
+    hb_shape_cache_get_stats (cache, &hits, &misses);
+    g_assert_cmpuint (hits, >, 0);
+
+    g_assert (hb_feature_from_string ("dnom[4:7]", -1, &features[0]));
+    check_shape_cache (cache, font, "123 123 123", features, 1);
+    g_assert (hb_feature_from_string ("numr[0:5]", -1, &features[1]));
+    check_shape_cache (cache, font, "123 123 123", features, 2);
+    g_assert (hb_feature_from_string ("dnom[8:]", -1, &features[0]));
+    check_shape_cache (cache, font, "123 123 123", features, 1);
+  }
+  hb_shape_cache_destroy (cache);
+  hb_font_destroy (font);
+}
+
+static hb_buffer_t *
+shape_incremental_text (hb_font_t *font, const uint32_t *text, unsigned int length,
+			hb_direction_t direction)
+{
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_buffer_add_utf32 (buffer, text, length, 0, length);
+  hb_buffer_set_direction (buffer, direction);
+  hb_buffer_set_script (buffer, HB_SCRIPT_LATIN);
+  hb_buffer_set_flags (buffer, HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT);
+  hb_shape (font, buffer, NULL, 0);
+  return buffer;
+}
+
+typedef struct {
+  unsigned int start, end;
+  const char *replacement;
+} edit_t;
+
+/* Applies @edits to @initial one by one with hb_shape_incremental(), and
+ * checks each result against shaping the new text from scratch. */
+static void
+check_shape_incremental (hb_font_t *font, const char *initial,
+			 const edit_t *edits, unsigned int num_edits)
+{
+  unsigned int d, e, i;
+
+  for (d = 0; d < 2; d++)
+  {
+    hb_direction_t direction = d ? HB_DIRECTION_RTL : HB_DIRECTION_LTR;
+    uint32_t text[64];
+    unsigned int length = 0;
+    hb_buffer_t *buffer;
+
+    for (i = 0; initial[i]; i++)
+      text[length++] = (unsigned char) initial[i];
+    buffer = shape_incremental_text (font, text, length, direction);
+
+    for (e = 0; e < num_edits; e++)
+    {
+      hb_buffer_t *replacement = hb_buffer_create ();
+      hb_buffer_t *expected;
+      hb_glyph_info_t *infos;
+      unsigned int replacement_length;
+
+      hb_buffer_add_utf8 (replacement, edits[e].replacement, -1, 0, -1);
+      replacement_length = hb_buffer_get_length (replacement);
+      infos = hb_buffer_get_glyph_infos (replacement, NULL);
+      memmove (text + edits[e].start + replacement_length, text + edits[e].end,
+	       (length - edits[e].end) * sizeof (text[0]));
+      for (i = 0; i < replacement_length; i++)
+	text[edits[e].start + i] = infos[i].codepoint;
+      length += replacement_length - (edits[e].end - edits[e].start);
+      hb_buffer_destroy (replacement);
+
+      g_assert (hb_shape_incremental (font, buffer, text, length,
+				      edits[e].start, edits[e].end, replacement_length,
+				      NULL, 0, NULL));
+      expected = shape_incremental_text (font, text, length, direction);
+      assert_buffers_equal (buffer, expected);
+      hb_buffer_destroy (expected);
+    }
+
+    hb_buffer_destroy (buffer);
+  }
+}
+
+static void
+test_shape_incremental (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abcAE.ttf");
+  hb_font_t *font = hb_font_create (face);
+  /* Edits of "abc AEabc cba". */
+  const edit_t edits[] = {
+    {0, 0, "A"},
+    {5, 7, ""},
+    {3, 4, "bb"},
+    {12, 12, "c\xcc\x81"},
+    {0, 2, "E"},
+  };
+  /* Edits of "12 34 5678 90" that make and unmake fractions, which change
+   * every digit around the fraction slash, so the window must grow. */
+  const edit_t fraction_edits[] = {
+    {5, 6, "\xe2\x81\x84"},
+    {2, 3, "\xe2\x81\x84"},
+    {8, 9, ""},
+    {5, 6, " "},
+    {0, 0, "3\xe2\x81\x84"},
+    {7, 12, "1"},
+  };
+  hb_face_destroy (face);
+
+  check_shape_incremental (font, "abc AEabc cba", edits, G_N_ELEMENTS (edits));
+  hb_font_destroy (font);
+
+  face = hb_test_open_font_file ("fonts/automatic-fractions.ttf");
+  font = hb_font_create (face);
+  hb_face_destroy (face);
+  check_shape_incremental (font, "12 34 5678 90", fraction_edits, G_N_ELEMENTS (fraction_edits));
+  hb_font_destroy (font);
+}
+
+static void
+dispatch_reversed (hb_shape_parallel_task_func_t task,
+		   void *task_data,
+		   unsigned int num_tasks,
+		   void *user_data)
+{
+  unsigned int *count = (unsigned int *) user_data;
+  unsigned int i;
+
+  for (i = num_tasks; i; i--)
+    task (task_data, i - 1);
+  *count += num_tasks;
+}
+
+/* Shapes @text with hb_shape_parallel(), with both the built-in and a
+ * custom dispatcher, and checks the result against hb_shape(). */
+static void
+check_shape_parallel (hb_font_t *font, const char *text,
+		      const hb_feature_t *features, unsigned int num_features)
+{
+  unsigned int d, m;
+
+  for (d = 0; d < 2; d++)
+    for (m = 0; m < 2; m++)
+    {
+      hb_direction_t direction = d ? HB_DIRECTION_RTL : HB_DIRECTION_LTR;
+      hb_buffer_t *expected = create_buffer (text, direction);
+      hb_buffer_t *buffer = create_buffer (text, direction);
+      unsigned int num_tasks = 0;
+
+      hb_shape (font, expected, features, num_features);
+      if (m)
+	g_assert (hb_shape_parallel (font, buffer, features, num_features, NULL, 4, NULL, NULL));
+      else
+      {
+	g_assert (hb_shape_parallel (font, buffer, features, num_features, NULL, 4,
+				     dispatch_reversed, &num_tasks));
+	g_assert_cmpuint (num_tasks, >, 1);
+      }
+      assert_buffers_equal (buffer, expected);
+
+      hb_buffer_destroy (buffer);
+      hb_buffer_destroy (expected);
+    }
+}
+
+static void
+test_shape_parallel (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abcAE.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_feature_t features[2];
+  hb_face_destroy (face);
+
+  check_shape_parallel (font, "ab abc AE cba c\xcc\x81 AEab bca abc ab", NULL, 0);
+  hb_font_destroy (font);
+
+  /* Features applied to ranges that cross the pieces. */
+  face = hb_test_open_font_file ("fonts/automatic-fractions.ttf");
+  font = hb_font_create (face);
+  hb_face_destroy (face);
+  g_assert (hb_feature_from_string ("dnom[6:21]", -1, &features[0]));
+  g_assert (hb_feature_from_string ("numr[18:]", -1, &features[1]));
+  check_shape_parallel (font, "1234 5678 9012 3456 7890 1234 5678", features, 2);
+  /* Fractions are not split. */
+  check_shape_parallel (font, "1234 5678 90\xe2\x81\x84" "12 3456 7890 1234", NULL, 0);
+  hb_font_destroy (font);
+}
+
 static void
 test_shape_clusters (void)
 {
@@ -199,6 +685,12 @@ main (int argc, char **argv)
   hb_test_init (&argc, &argv);
 
   hb_test_add (test_shape);
+  hb_test_add (test_shape_batch);
+  hb_test_add (test_shape_plan_cache);
+  hb_test_add (test_shape_plan_prebuild);
+  hb_test_add (test_shape_cache);
+  hb_test_add (test_shape_incremental);
+  hb_test_add (test_shape_parallel);
   hb_test_add (test_shape_clusters);
   /* TODO test fallback shaper */
   /* TODO test shaper_full */
@@ -73,11 +73,15 @@ struct shape_consumer_t : shape_options_t
 	if (hb_buffer_get_content_type (buffer) == HB_BUFFER_CONTENT_TYPE_GLYPHS)
 	  break;
 	else
+	{
+	  print_profile ();
 	  return true;
+	}
       }
     }
 
     output.consume_glyphs (buffer, text, text_len, utf8_clusters);
+    print_profile ();
     return true;
   }
   template <typename app_t>
@@ -38,6 +38,7 @@ struct shape_options_t
     g_free (script);
     free (features);
     g_strfreev (shapers);
+    hb_shape_plan_destroy (profile_plan);
   }
 
   void add_options (option_parser_t *parser);
@@ -93,6 +94,29 @@ struct shape_options_t
 
   hb_bool_t shape (hb_font_t *font, hb_buffer_t *buffer, const char **error=nullptr)
   {
+    if (profile)
+    {
+      /* Same plan that hb_shape_full() is about to pick from the cache.
+       * Buffers can have different properties, so look it up for each. */
+      hb_segment_properties_t props;
+      hb_buffer_get_segment_properties (buffer, &props);
+      unsigned int num_coords;
+      const int *coords = hb_font_get_var_coords_normalized (font, &num_coords);
+      hb_shape_plan_t *plan = hb_shape_plan_create_cached2 (hb_font_get_face (font), &props,
+							    features, num_features,
+							    coords, num_coords,
+							    shapers);
+      if (plan != profile_plan)
+      {
+	print_profile ();
+	profile_plan = plan;
+	hb_ot_shape_plan_set_profiling (profile_plan, true);
+	hb_ot_shape_plan_reset_profile (profile_plan);
+      }
+      else
+	hb_shape_plan_destroy (plan);
+    }
+
     if (!hb_shape_full (font, buffer, features, num_features, shapers))
     {
       if (error)
@@ -109,6 +133,46 @@ struct shape_options_t
     return false;
   }
 
+  void print_profile ()
+  {
+    if (!profile_plan)
+      return;
+
+    unsigned int count = hb_ot_shape_plan_get_lookup_profiles (profile_plan, 0, nullptr, nullptr);
+    hb_ot_shape_plan_lookup_profile_t *lookups = (hb_ot_shape_plan_lookup_profile_t *) calloc (count, sizeof (*lookups));
+    hb_ot_shape_plan_get_lookup_profiles (profile_plan, 0, &count, lookups);
+    for (unsigned int i = 0; i < count; i++)
+    {
+      char tag[5] = {0};
+      hb_tag_to_string (lookups[i].table_tag, tag);
+      fprintf (stderr, "%s stage %u lookup %u: %u runs, %u glyphs visited, %u applied, %.3fus\n",
+	       tag, lookups[i].stage_index, lookups[i].lookup_index,
+	       lookups[i].invocations, lookups[i].glyphs_visited, lookups[i].applications,
+	       lookups[i].time_ns / 1000.);
+    }
+    free (lookups);
+
+    count = hb_ot_shape_plan_get_stage_profiles (profile_plan, 0, nullptr, nullptr);
+    hb_ot_shape_plan_stage_profile_t *stages = (hb_ot_shape_plan_stage_profile_t *) calloc (count, sizeof (*stages));
+    hb_ot_shape_plan_get_stage_profiles (profile_plan, 0, &count, stages);
+    for (unsigned int i = 0; i < count; i++)
+    {
+      char tag[5] = {0};
+      hb_tag_to_string (stages[i].table_tag, tag);
+      fprintf (stderr, "%s stage %u: %u runs, %.3fus, %.3fus in pause\n",
+	       tag, stages[i].stage_index, stages[i].invocations,
+	       stages[i].time_ns / 1000., stages[i].pause_time_ns / 1000.);
+    }
+    free (stages);
+
+    /* Clear the counts, so they do not carry over if the plan is
+     * profiled again. */
+    hb_ot_shape_plan_reset_profile (profile_plan);
+    hb_ot_shape_plan_set_profiling (profile_plan, false);
+    hb_shape_plan_destroy (profile_plan);
+    profile_plan = nullptr;
+  }
+
   void shape_closure (const char *text, int text_len,
 		      hb_font_t *font, hb_buffer_t *buffer,
 		      hb_set_t *glyphs)
@@ -142,6 +206,9 @@ struct shape_options_t
   hb_bool_t unsafe_to_concat = false;
   hb_bool_t safe_to_insert_tatweel = false;
   unsigned int num_iterations = 1;
+  hb_bool_t profile = false;
+
+  hb_shape_plan_t *profile_plan = nullptr;
 };
 
 
@@ -269,6 +336,7 @@ shape_options_t::add_options (option_parser_t *parser)
     {"verify",		0, 0, G_OPTION_ARG_NONE,	&this->verify,			"Perform sanity checks on shaping results",	nullptr},
     {"num-iterations", 'n', G_OPTION_FLAG_IN_MAIN,
 			      G_OPTION_ARG_INT,		&this->num_iterations,		"Run shaper N times (default: 1)",	"N"},
+    {"profile",		0, 0, G_OPTION_ARG_NONE,	&this->profile,			"Print per-lookup shaping statistics to stderr",	nullptr},
     {nullptr}
   };
   parser->add_group (entries,